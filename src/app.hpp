@@ -17,16 +17,31 @@ using HWND = void*;
 #endif
 #include <GLFW/glfw3native.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <tuple>
 
 #include "shared.inl"
 #include "camera.hpp"
 #include "chunk.hpp"
+#include "terrain.hpp"
+#include "jobs.hpp"
+#include "streaming.hpp"
+#include "region.hpp"
+#include "world_cache.hpp"
+#include "hiz.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include "glm/gtx/hash.hpp"
 
 #include <unordered_map>
+#include <unordered_set>
 
 #include "textures.hpp"
 
@@ -60,6 +75,14 @@ auto get_native_handle(GLFWwindow* glfw_window_ptr)
 #endif
 }
 
+static constexpr u32 MESH_ARENA_SIZE = 256 * 1024 * 1024;
+static constexpr u32 UPLOAD_RING_SIZE = 64 * 1024 * 1024;
+static constexpr u32 UPLOAD_FRAME_BUDGET = 8 * 1024 * 1024;
+// voxels and meshes of visited chunks can be kept in a memory mapped file so revisiting an area starts instantly,
+// off by default because the file is created at its full size, which Windows allocates on disk right away
+static constexpr bool USE_WORLD_CACHE = false;
+static constexpr u64 WORLD_CACHE_SIZE = 1024ull * 1024 * 1024;
+
 struct App {
     GLFWwindow* glfw_window_ptr = {};
 
@@ -68,28 +91,33 @@ struct App {
     daxa::Swapchain swapchain = {};
     daxa::PipelineManager pipeline_manager = {};
     std::shared_ptr<daxa::RasterPipeline> raster_pipeline = {};
+    std::shared_ptr<daxa::RasterPipeline> face_raster_pipeline = {};
+    std::unique_ptr<MeshArena> meshArena = {};
+    std::unique_ptr<UploadManager> uploads = {};
+    std::unique_ptr<ChunkDrawList> drawList = {};
+    std::unique_ptr<HiZPyramid> hiz = {};
+    // what the depth in hiz was rendered with, chunks are tested for occlusion through it
+    glm::mat4 previous_view_projection = {};
+    daxa::BufferId quadIndexBuffer = {};
     std::unordered_map<glm::ivec3, std::unique_ptr<Chunk>> chunks = {};
     daxa::ImageId depthBuffer = {};
     std::unique_ptr<Textures> texture = {};
 
-    // noise generator - generates random values - used for world generation
-    FastNoise::SmartNode<> generator = []() {
-        auto OpenSimplex = FastNoise::New<FastNoise::OpenSimplex2>();
-        auto FractalFBm = FastNoise::New<FastNoise::FractalFBm>();
-        FractalFBm->SetSource(OpenSimplex);
-        FractalFBm->SetGain(0.280f);
-        FractalFBm->SetOctaveCount(4);
-        FractalFBm->SetLacunarity(4.0f);
-        auto DomainScale = FastNoise::New<FastNoise::DomainScale>();
-        DomainScale->SetSource(FractalFBm);
-        DomainScale->SetScale(0.86f);
-        auto PosationOutput = FastNoise::New<FastNoise::PositionOutput>();
-        PosationOutput->Set<FastNoise::Dim::Y>(6.72f);
-        auto add = FastNoise::New<FastNoise::Add>();
-        add->SetLHS(DomainScale);
-        add->SetRHS(PosationOutput);
-        return add;
-    }();
+    // shared by every generation job
+    WorldGenerator worldGenerator{};
+    // chunks generated in earlier runs are read back from here instead of generated again,
+    // both only hand out chunks generated with the same settings
+    RegionStorage regions{"world", worldGenerator.key()};
+    std::unique_ptr<WorldCache> worldCache = USE_WORLD_CACHE
+        ? std::make_unique<WorldCache>("world/cache.bin", worldGenerator.key(), WORLD_CACHE_SIZE)
+        : nullptr;
+
+    // greedy meshing by default, F3 switches to naive to compare vertex counts and build times
+    MesherType mesher = MesherType::Greedy;
+    // F1 switches between the two backends at runtime to compare memory and frame time
+    MeshBackend meshBackend = MeshBackend::Vertices;
+    // F2 switches between culling in a compute pass with indirect draws and culling and drawing chunk by chunk on the CPU
+    bool gpu_culling = true;
 
     u32 size_x = 800, size_y = 600;
     bool minimized = false;
@@ -100,6 +128,43 @@ struct App {
     f64 current_frame = glfwGetTime();
     f64 last_frame = current_frame;
     f64 delta_time{};
+    f64 frame_time_sum = 0.0;
+    u32 frame_count = 0;
+    // face buckets the last frame drew, and chunks it skipped because they were outside the frustum or hidden
+    u32 chunk_draws = 0;
+    u32 culled_chunks = 0;
+    u32 occluded_chunks = 0;
+
+    struct FinishedMesh {
+        glm::ivec3 chunkPos;
+        u64 generation; // the chunk's meshGeneration when the mesh was scheduled
+        ChunkMesh mesh;
+    };
+
+    // declared after worldGenerator, the layers it loads are the ones the generator's surface can reach
+    ChunkStreamer streamer{StreamingSettings { .meshedLayers = worldGenerator.surfaceLayers() }};
+    // chunks handed to the workers for generation and not back yet
+    std::unordered_set<glm::ivec3> generatingChunks = {};
+
+    // chunks generated and meshes finished by the workers
+    std::mutex finishedMutex = {};
+    std::vector<std::unique_ptr<Chunk>> generatedChunks = {};
+    std::vector<FinishedMesh> finishedMeshes = {};
+    // chunks waiting for their neighbours before they can be meshed, and meshes waiting for upload budget
+    std::vector<glm::ivec3> meshQueue = {};
+    std::deque<FinishedMesh> pendingUploads = {};
+    std::vector<std::unique_ptr<Chunk>> evictedChunks = {};
+    u32 loadingChunks = 0;
+    // every scheduled mesh gets the next generation, shared by all chunks so a chunk that was evicted and loaded
+    // again never matches a mesh job of its previous load
+    u64 nextMeshGeneration = 1;
+    std::chrono::steady_clock::time_point loadStart = {};
+    // chunks read from the region files or the world cache instead of generated, and meshes taken from the cache, since startup
+    std::atomic<u32> loadedChunks = 0;
+    u32 cachedMeshes = 0;
+
+    // declared last so the workers are joined before anything they use is destroyed
+    JobSystem jobs{};
 
     App() {
         glfwInit();
@@ -170,43 +235,44 @@ struct App {
         depthBuffer = device.create_image({
             .format = daxa::Format::D32_SFLOAT,
             .size = {size_x, size_y, 1},
-            .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
+            .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
         });
 
-        raster_pipeline = pipeline_manager.add_raster_pipeline(daxa::RasterPipelineCompileInfo {
-            .vertex_shader_info = daxa::ShaderCompileInfo {
-                .source = daxa::ShaderSource { daxa::ShaderFile { .path = "src/shader.glsl" }, },
-            },
-            .fragment_shader_info = daxa::ShaderCompileInfo {
-                .source = daxa::ShaderSource { daxa::ShaderFile { .path = "src/shader.glsl" }, },
-            },
-            .color_attachments = {{ .format = swapchain.get_format() }},
-            .depth_test = {
-                .depth_attachment_format = daxa::Format::D32_SFLOAT,
-                .enable_depth_test = true,
-                .enable_depth_write = true,
-            },
-            .raster = {
-                .face_culling = daxa::FaceCullFlagBits::NONE
-            },
-            .push_constant_size = sizeof(DrawPush),
-        }).value();
+        auto create_raster_pipeline = [&](const std::vector<daxa::ShaderDefine> &defines) {
+            return pipeline_manager.add_raster_pipeline(daxa::RasterPipelineCompileInfo {
+                .vertex_shader_info = daxa::ShaderCompileInfo {
+                    .source = daxa::ShaderSource { daxa::ShaderFile { .path = "src/shader.glsl" }, },
+                    .compile_options = { .defines = defines },
+                },
+                .fragment_shader_info = daxa::ShaderCompileInfo {
+                    .source = daxa::ShaderSource { daxa::ShaderFile { .path = "src/shader.glsl" }, },
+                    .compile_options = { .defines = defines },
+                },
+                .color_attachments = {{ .format = swapchain.get_format() }},
+                .depth_test = {
+                    .depth_attachment_format = daxa::Format::D32_SFLOAT,
+                    .enable_depth_test = true,
+                    .enable_depth_write = true,
+                },
+                // the mesher winds quads counter-clockwise seen from outside, the flipped projection keeps that on screen
+                .raster = {
+                    .face_culling = daxa::FaceCullFlagBits::BACK_BIT,
+                    .front_face_winding = daxa::FrontFaceWinding::COUNTER_CLOCKWISE,
+                },
+                .push_constant_size = sizeof(DrawPush),
+            }).value();
+        };
 
-        static constexpr i32 worldSizeX = 16;
-        static constexpr i32 worldSizeY = 1;
-        static constexpr i32 worldSizeZ = 16;
+        raster_pipeline = create_raster_pipeline({});
+        face_raster_pipeline = create_raster_pipeline({{ .name = "FACE_PULLING", .value = "1" }});
 
-        u32 chunkAmount = 0;
+        meshArena = std::make_unique<MeshArena>(device, MESH_ARENA_SIZE);
+        quadIndexBuffer = createQuadIndexBuffer(device);
+        uploads = std::make_unique<UploadManager>(device, UPLOAD_RING_SIZE, UPLOAD_FRAME_BUDGET);
+        drawList = std::make_unique<ChunkDrawList>(device, pipeline_manager);
+        hiz = std::make_unique<HiZPyramid>(device, pipeline_manager, size_x, size_y);
 
-        for (i32 x = -worldSizeX; x <= worldSizeX; x++) {
-            for (i32 y = -worldSizeY; y <= worldSizeY; y++) {
-                for (i32 z = -worldSizeZ; z <= worldSizeZ; z++) {
-                    chunkAmount++;
-                    std::unique_ptr<Chunk> chunk = std::make_unique<Chunk>(device, glm::ivec3{x, y, z}, generator);
-                    this->chunks.insert({glm::ivec3{x, y, z}, std::move(chunk)});
-                }
-            }
-        }
+        loadStart = std::chrono::steady_clock::now();
 
         camera.camera.resize(size_x, size_y);
 
@@ -214,12 +280,272 @@ struct App {
     }
 
     ~App() {
+        // everything the workers still have queued is finished first, the dirty chunks are saved last
+        jobs.wait();
+        for (const auto& [key, chunk]: chunks) {
+            if (chunk->dirty) {
+                jobs.schedule([this, chunkPos = key, &voxels = chunk->voxels] { regions.save(chunkPos, voxels); });
+            }
+        }
+        jobs.wait();
+
         device.wait_idle();
         device.destroy_image(depthBuffer);
+        device.destroy_buffer(quadIndexBuffer);
         glfwDestroyWindow(glfw_window_ptr);
         glfwTerminate();
     }
 
+    // camera position and view direction in world space, the view matrix translates by -position
+    glm::vec3 camera_world_position() const {
+        return -camera.position;
+    }
+
+    glm::vec3 camera_view_direction() const {
+        const glm::mat4 &rotation = camera.camera.rotationMat;
+        return -glm::vec3{rotation[0][2], rotation[1][2], rotation[2][2]};
+    }
+
+    // noise and meshing run on the job system, the main thread only decides what to load and uploads in update_chunks
+    void stream_chunks() {
+        if (streamer.update(camera_world_position(), camera_view_direction())) {
+            // evicted chunks keep their mesh until their draw slot is cleared
+            for (auto it = chunks.begin(); it != chunks.end();) {
+                if (streamer.shouldKeep(it->first)) {
+                    ++it;
+                    continue;
+                }
+                if (it->second->dirty) {
+                    jobs.schedule([this, chunkPos = it->first, voxels = it->second->voxels] { regions.save(chunkPos, voxels); });
+                }
+                evictedChunks.push_back(std::move(it->second));
+                it = chunks.erase(it);
+            }
+            std::erase_if(meshQueue, [&](const glm::ivec3 &chunkPos) { return !chunks.contains(chunkPos); });
+
+            // chunks that crossed a lod distance get remeshed, they keep drawing the old mesh until then
+            for (const auto& [key, chunk]: chunks) {
+                if (chunk->scheduledLod.has_value() && *chunk->scheduledLod != streamer.lodFor(key)) {
+                    chunk->scheduledLod = std::nullopt;
+                    meshQueue.push_back(key);
+                }
+            }
+        }
+
+        // only a few generations are in flight at once so turning around reprioritizes quickly
+        u32 freeSlots = jobs.threadCount * 2 - std::min(jobs.threadCount * 2, static_cast<u32>(generatingChunks.size()));
+        std::vector<glm::ivec3> requests = streamer.nextRequests(freeSlots, [&](const glm::ivec3 &chunkPos) {
+            return chunks.contains(chunkPos) || generatingChunks.contains(chunkPos);
+        });
+
+        if (!requests.empty() && loadingChunks == 0 && generatingChunks.empty()) {
+            loadStart = std::chrono::steady_clock::now();
+        }
+
+        // requests stacked on top of each other are generated together, every run along y shares one noise call
+        std::sort(requests.begin(), requests.end(), [](const glm::ivec3 &a, const glm::ivec3 &b) {
+            return std::tie(a.x, a.z, a.y) < std::tie(b.x, b.z, b.y);
+        });
+        for (usize first = 0; first < requests.size();) {
+            usize count = 1;
+            while (first + count < requests.size() && requests[first + count] == requests[first] + glm::ivec3{0, static_cast<i32>(count), 0}) {
+                count++;
+            }
+            for (usize i = 0; i < count; i++) {
+                generatingChunks.insert(requests[first + i]);
+            }
+
+            jobs.schedule([this, firstChunk = requests[first], count] {
+                std::vector<std::unique_ptr<Chunk>> column = {};
+                std::vector<ChunkVoxels *> missing(count, nullptr);
+                for (usize i = 0; i < count; i++) {
+                    column.push_back(std::make_unique<Chunk>(*meshArena, firstChunk + glm::ivec3{0, static_cast<i32>(i), 0}));
+                    if (!load_stored_voxels(*column.back())) {
+                        missing[i] = &column.back()->voxels;
+                        column.back()->dirty = true;
+                    }
+                }
+
+                if (std::any_of(missing.begin(), missing.end(), [](ChunkVoxels *voxels) { return voxels != nullptr; })) {
+                    worldGenerator.generateBatch(missing, firstChunk, {1, static_cast<i32>(count), 1});
+                    for (const std::unique_ptr<Chunk> &chunk : column) {
+                        if (chunk->dirty && worldCache) { worldCache->storeVoxels(chunk->pos, chunk->voxels); }
+                    }
+                }
+
+                std::lock_guard lock{finishedMutex};
+                for (std::unique_ptr<Chunk> &chunk : column) {
+                    generatedChunks.push_back(std::move(chunk));
+                }
+            });
+            first += count;
+        }
+    }
+
+    // reads a chunk from the world cache or the region files, worker threads only
+    bool load_stored_voxels(Chunk &chunk) {
+        if (worldCache && worldCache->loadVoxels(chunk.pos, chunk.voxels)) {
+            loadedChunks++;
+            return true;
+        }
+        if (regions.load(chunk.pos, chunk.voxels)) {
+            loadedChunks++;
+            if (worldCache) { worldCache->storeVoxels(chunk.pos, chunk.voxels); }
+            return true;
+        }
+        return false;
+    }
+
+    // meshes every queued chunk whose neighbours are all generated, with a padded copy of its voxels,
+    // chunks on the edge of the loaded area stay unmeshed until the area grows past them and the layers loaded only as
+    // neighbours never are
+    void schedule_meshing() {
+        std::erase_if(meshQueue, [&](const glm::ivec3 &chunkPos) {
+            if (!streamer.shouldMesh(chunkPos)) { return false; }
+            std::array<const ChunkVoxels *, 6> neighbors = {};
+            for (u32 face = 0; face < 6; face++) {
+                auto neighbor = chunks.find(chunkPos + FACE_NORMALS[face]);
+                if (neighbor == chunks.end()) { return false; }
+                neighbors[face] = &neighbor->second->voxels;
+            }
+
+            Chunk &chunk = *chunks.at(chunkPos);
+            chunk.scheduledLod = streamer.lodFor(chunkPos);
+            chunk.meshGeneration = nextMeshGeneration++;
+            loadingChunks++;
+            jobs.schedule([this, chunkPos, generation = chunk.meshGeneration, lod = *chunk.scheduledLod, voxels = PaddedVoxels{chunk.voxels, neighbors}] {
+                ChunkMesh mesh = meshChunk(voxels, mesher, meshBackend, lod);
+                if (worldCache) { worldCache->storeMesh(chunkPos, mesher, mesh); }
+                std::lock_guard lock{finishedMutex};
+                finishedMeshes.push_back({chunkPos, generation, std::move(mesh)});
+            });
+            return true;
+        });
+    }
+
+    // streams chunks in and out, takes over the workers' results, schedules meshing and stages finished
+    // meshes until the frame's upload budget is used up, then submits them as one batch
+    void update_chunks() {
+        meshArena->beginFrame(swapchain.get_cpu_timeline_value(), swapchain.get_gpu_timeline_semaphore().value());
+
+        stream_chunks();
+
+        {
+            std::lock_guard lock{finishedMutex};
+            for (std::unique_ptr<Chunk> &chunk : generatedChunks) {
+                glm::ivec3 chunkPos = chunk->pos;
+                generatingChunks.erase(chunkPos);
+                // the camera moved away while it was being generated
+                if (!streamer.shouldKeep(chunkPos)) { continue; }
+
+                // a cached mesh doesn't have to wait for the neighbours, it goes straight to the upload queue
+                ChunkMesh cachedMesh = {};
+                const u32 lod = streamer.lodFor(chunkPos);
+                if (worldCache && worldCache->loadMesh(chunkPos, mesher, meshBackend, lod, cachedMesh)) {
+                    chunk->scheduledLod = lod;
+                    chunk->meshGeneration = nextMeshGeneration++;
+                    loadingChunks++;
+                    cachedMeshes++;
+                    pendingUploads.push_back({chunkPos, chunk->meshGeneration, std::move(cachedMesh)});
+                } else {
+                    meshQueue.push_back(chunkPos);
+                }
+                chunk->drawSlot = drawList->allocateSlot();
+                this->chunks.insert({chunkPos, std::move(chunk)});
+            }
+            generatedChunks.clear();
+            for (FinishedMesh &finished : finishedMeshes) {
+                pendingUploads.push_back(std::move(finished));
+            }
+            finishedMeshes.clear();
+        }
+
+        schedule_meshing();
+
+        while (!evictedChunks.empty() && uploads->canStage(sizeof(ChunkDescriptor))) {
+            drawList->writeSlot(evictedChunks.back()->drawSlot, {}, *uploads);
+            drawList->freeSlot(evictedChunks.back()->drawSlot);
+            evictedChunks.pop_back();
+        }
+
+        while (!pendingUploads.empty()) {
+            auto &[chunkPos, generation, mesh] = pendingUploads.front();
+            // evicted chunks drop their meshes, and so do chunks that were remeshed since, the workers can finish
+            // the two jobs in either order
+            auto chunk = chunks.find(chunkPos);
+            if (chunk != chunks.end() && chunk->second->meshGeneration == generation &&
+                !chunk->second->uploadMesh(mesh, *uploads, *drawList)) { break; }
+            pendingUploads.pop_front();
+
+            if (--loadingChunks == 0 && generatingChunks.empty()) {
+                f64 loadTime = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+                std::cout << "streamed " << chunks.size() << " chunks on " << jobs.threadCount << " threads in " << loadTime << " ms ("
+                          << loadedChunks.load() << " read from disk and " << cachedMeshes << " meshes from the world cache since startup), "
+                          << static_cast<f64>(uploads->totalUploadedBytes) / (1024.0 * 1024.0) << " MiB uploaded so far" << std::endl;
+                print_mesh_stats();
+            }
+        }
+
+        uploads->flush();
+    }
+
+    void print_mesh_stats() {
+        u64 quadAmount = 0;
+        f64 meshTime = 0.0;
+        for (const auto& [key, chunk]: chunks) {
+            quadAmount += chunk->quadCount;
+            meshTime += chunk->meshTime;
+        }
+
+        std::cout << (mesher == MesherType::Greedy ? "greedy" : "naive") << " mesher, "
+                  << (meshBackend == MeshBackend::Faces ? "face" : "vertex") << " backend: "
+                  << quadAmount << " quads, " << meshTime << " ms" << std::endl;
+
+        MeshArenaStats arenaStats = meshArena->getStats();
+        std::cout << "mesh arena: " << static_cast<f64>(arenaStats.usedBytes) / (1024.0 * 1024.0) << " / "
+                  << static_cast<f64>(arenaStats.capacity) / (1024.0 * 1024.0) << " MiB used by "
+                  << arenaStats.allocationCount << " meshes, " << arenaStats.freeBlockCount << " free blocks, "
+                  << arenaStats.fragmentation * 100.0f << "% fragmented" << std::endl;
+
+        usize voxelBytes = 0;
+        usize uniformChunks = 0;
+        for (const auto& [key, chunk]: chunks) {
+            voxelBytes += chunk->voxels.memoryUsage();
+            uniformChunks += chunk->voxels.isUniform() ? 1 : 0;
+        }
+        const usize denseBytes = chunks.size() * CHUNK_VOLUME * sizeof(BlockID);
+        std::cout << "voxels: " << static_cast<f64>(voxelBytes) / (1024.0 * 1024.0) << " MiB, "
+                  << static_cast<f64>(denseBytes) / static_cast<f64>(std::max<usize>(voxelBytes, 1)) << "x smaller than dense, "
+                  << uniformChunks << " uniform chunks" << std::endl;
+    }
+
+    void toggle_mesh_backend() {
+        if (loadingChunks != 0 || !generatingChunks.empty()) { return; }
+
+        meshBackend = meshBackend == MeshBackend::Vertices ? MeshBackend::Faces : MeshBackend::Vertices;
+        remesh_all();
+    }
+
+    void toggle_mesher() {
+        if (loadingChunks != 0 || !generatingChunks.empty()) { return; }
+
+        mesher = mesher == MesherType::Greedy ? MesherType::Naive : MesherType::Greedy;
+        remesh_all();
+    }
+
+    // chunks keep drawing their old mesh until the new one is uploaded, the timings printed once they all are compare the two
+    void remesh_all() {
+        loadStart = std::chrono::steady_clock::now();
+        for (const auto& [key, chunk]: chunks) {
+            if (chunk->scheduledLod.has_value()) {
+                chunk->scheduledLod = std::nullopt;
+                meshQueue.push_back(key);
+            }
+        }
+        frame_time_sum = 0.0;
+        frame_count = 0;
+    }
+
     void update() {
         while (!glfwWindowShouldClose(glfw_window_ptr)) {
             glfwPollEvents();
@@ -232,6 +558,23 @@ struct App {
             camera.camera.setRotation(camera.rotation.x, camera.rotation.y);
             camera.update(delta_time);
 
+            frame_time_sum += delta_time;
+            frame_count++;
+            if (frame_time_sum >= 1.0) {
+                if (gpu_culling) {
+                    chunk_draws = drawList->drawCount();
+                    culled_chunks = drawList->culledCount();
+                    occluded_chunks = drawList->occludedCount();
+                }
+                std::cout << (meshBackend == MeshBackend::Faces ? "face" : "vertex") << " backend, "
+                          << (gpu_culling ? "gpu" : "cpu") << " culling: "
+                          << frame_time_sum * 1000.0 / static_cast<f64>(frame_count) << " ms/frame, "
+                          << chunk_draws << " face bucket draws, " << culled_chunks << " culled, " << occluded_chunks << " occluded" << std::endl;
+                frame_time_sum = 0.0;
+                frame_count = 0;
+            }
+
+            update_chunks();
             render();
         }
     }
@@ -244,6 +587,25 @@ struct App {
             .name = "render command list"
         });
 
+        glm::mat4 viewProjection = camera.camera.getViewProjection();
+        Frustum frustum{viewProjection};
+        if (gpu_culling) {
+            drawList->cull(cmd_list, frustum, camera_world_position(), *hiz, previous_view_projection, swapchain.get_cpu_timeline_value());
+        } else {
+            // the pyramid isn't rebuilt while culling on the CPU
+            hiz->valid = false;
+            occluded_chunks = 0;
+        }
+
+        // the depth buffer is cleared, its old contents were only read by the last pyramid build
+        cmd_list.pipeline_barrier_image_transition({
+            .src_access = daxa::AccessConsts::COMPUTE_SHADER_READ,
+            .dst_access = daxa::AccessConsts::READ_WRITE,
+            .src_layout = daxa::ImageLayout::UNDEFINED,
+            .dst_layout = daxa::ImageLayout::ATTACHMENT_OPTIMAL,
+            .image_id = depthBuffer,
+        });
+
         cmd_list.begin_renderpass( daxa::RenderPassBeginInfo {
             .color_attachments = { daxa::RenderAttachmentInfo {
                 .image_view = swapchain_image.default_view(),
@@ -258,24 +620,79 @@ struct App {
             .render_area = {.x = 0, .y = 0, .width = size_x, .height = size_y},
         });
 
-        cmd_list.set_pipeline(*raster_pipeline);
-
-        for (const auto& [key, chunk]: chunks) {
-            glm::mat4 model = glm::translate(glm::mat4{1.0f}, glm::vec3{chunk->pos * 16});
-            glm::mat4 mvp = camera.camera.getViewProjection() * model;
-            if (chunk->renderable) {
-                cmd_list.push_constant(DrawPush {
-                        .modelViewProjection = *reinterpret_cast<f32mat4x4*>(&mvp),
-                        .vertices = device.get_device_address(chunk->faceBuffer),
-                        .textures = texture->atlas_texture_array.default_view(),
-                        .texturesSampler = texture->atlas_sampler
-                });
-                cmd_list.draw(daxa::DrawInfo { .vertex_count = chunk->chunkSize });
+        cmd_list.set_index_buffer(quadIndexBuffer, 0, sizeof(u32));
+
+        DrawPush push = {
+            .viewProjection = *reinterpret_cast<f32mat4x4*>(&viewProjection),
+            .chunks = device.get_device_address(drawList->descriptorBuffer),
+            .textures = texture->atlas_texture_array.default_view(),
+            .texturesSampler = texture->atlas_sampler
+        };
+
+        if (gpu_culling) {
+            // while the backend is switched chunks can still hold meshes of the old one, so both draws are recorded
+            cmd_list.set_pipeline(*raster_pipeline);
+            cmd_list.push_constant(push);
+            drawList->drawVertices(cmd_list);
+            cmd_list.set_pipeline(*face_raster_pipeline);
+            cmd_list.push_constant(push);
+            drawList->drawFaces(cmd_list);
+        } else {
+            std::optional<MeshBackend> boundBackend = std::nullopt;
+            glm::vec3 cameraPosition = camera_world_position();
+            chunk_draws = 0;
+            culled_chunks = 0;
+            for (const auto& [key, chunk]: chunks) {
+                if (chunk->renderable) {
+                    // vertices sit half a block below their block corners
+                    glm::vec3 chunkMin = glm::vec3{chunk->pos * CHUNK_SIZE} - 0.5f;
+                    glm::vec3 chunkMax = chunkMin + static_cast<f32>(CHUNK_SIZE);
+                    if (!frustum.intersectsBox(chunkMin, chunkMax)) {
+                        culled_chunks++;
+                        continue;
+                    }
+
+                    if (boundBackend != chunk->backend) {
+                        cmd_list.set_pipeline(chunk->backend == MeshBackend::Faces ? *face_raster_pipeline : *raster_pipeline);
+                        cmd_list.push_constant(push);
+                        boundBackend = chunk->backend;
+                    }
+
+                    u32 firstQuad = 0;
+                    for (u32 face = 0; face < 6; face++) {
+                        const u32 quadCount = chunk->faceQuadCounts[face];
+                        const i32 axis = static_cast<i32>(face / 2);
+                        // a bucket can only face the camera when the camera is on the outer side of its lowest or highest plane
+                        const bool visible = face % 2 == 0 ? cameraPosition[axis] < chunkMax[axis] : cameraPosition[axis] > chunkMin[axis];
+                        if (visible && quadCount != 0) {
+                            chunk_draws++;
+                            // the first instance tells the vertex shader which descriptor slot to read
+                            if (chunk->backend == MeshBackend::Faces) {
+                                cmd_list.draw(daxa::DrawInfo { .vertex_count = quadCount * 6, .first_vertex = firstQuad * 6, .first_instance = chunk->drawSlot });
+                            } else {
+                                cmd_list.draw_indexed(daxa::DrawIndexedInfo { .index_count = quadCount * 6, .first_index = firstQuad * 6, .first_instance = chunk->drawSlot });
+                            }
+                        }
+                        firstQuad += quadCount;
+                    }
+                }
             }
         }
 
         cmd_list.end_renderpass();
 
+        if (gpu_culling) {
+            cmd_list.pipeline_barrier_image_transition({
+                .src_access = daxa::AccessConsts::READ_WRITE,
+                .dst_access = daxa::AccessConsts::COMPUTE_SHADER_READ,
+                .src_layout = daxa::ImageLayout::ATTACHMENT_OPTIMAL,
+                .dst_layout = daxa::ImageLayout::READ_ONLY_OPTIMAL,
+                .image_id = depthBuffer,
+            });
+            hiz->build(cmd_list, depthBuffer.default_view());
+        }
+        previous_view_projection = viewProjection;
+
         cmd_list.complete();
 
         device.submit_commands({
@@ -304,8 +721,9 @@ struct App {
             depthBuffer = device.create_image({
                 .format = daxa::Format::D32_SFLOAT,
                 .size = {size_x, size_y, 1},
-                .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT,
+                .usage = daxa::ImageUsageFlagBits::DEPTH_STENCIL_ATTACHMENT | daxa::ImageUsageFlagBits::SHADER_SAMPLED,
             });
+            hiz->resize(size_x, size_y);
         }
     }
 
@@ -327,6 +745,15 @@ struct App {
         if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS) {
             toggle_pause();
         }
+        if (key == GLFW_KEY_F1 && action == GLFW_PRESS) {
+            toggle_mesh_backend();
+        }
+        if (key == GLFW_KEY_F2 && action == GLFW_PRESS) {
+            gpu_culling = !gpu_culling;
+        }
+        if (key == GLFW_KEY_F3 && action == GLFW_PRESS) {
+            toggle_mesher();
+        }
         if (!paused) {
             camera.on_key(key, action);
         }
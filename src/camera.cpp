@@ -23,6 +23,32 @@ glm::mat4 Camera3D::getView() {
     return translationMat * rotationMat;
 }
 
+Frustum::Frustum(const glm::mat4 &viewProjection) {
+    // rows of the matrix, glm stores it column major
+    glm::mat4 rows = glm::transpose(viewProjection);
+    planes = {
+        rows[3] + rows[0], rows[3] - rows[0],
+        rows[3] + rows[1], rows[3] - rows[1],
+        // the -w <= z near plane also holds for 0..1 depth, it's only a bit looser
+        rows[3] + rows[2], rows[3] - rows[2],
+    };
+}
+
+bool Frustum::intersectsBox(const glm::vec3 &min, const glm::vec3 &max) const {
+    for (const glm::vec4 &plane : planes) {
+        // the corner furthest along the plane normal
+        glm::vec3 corner = glm::vec3{
+            plane.x >= 0.0f ? max.x : min.x,
+            plane.y >= 0.0f ? max.y : min.y,
+            plane.z >= 0.0f ? max.z : min.z,
+        };
+        if (glm::dot(glm::vec3{plane}, corner) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void ControlledCamera3D::update(f32 dt) {
     auto delta_pos = speed * dt;
     if (move.sprint)
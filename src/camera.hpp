@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <daxa/types.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glm/ext/matrix_float4x4.hpp>
@@ -35,6 +36,16 @@ struct Camera3D {
 	glm::mat4 getView();
 };
 
+// the six clip planes of a view projection matrix, normals point inwards
+struct Frustum {
+	explicit Frustum(const glm::mat4 &viewProjection);
+
+	// false only when the box lies completely outside one of the planes
+	bool intersectsBox(const glm::vec3 &min, const glm::vec3 &max) const;
+
+	std::array<glm::vec4, 6> planes = {};
+};
+
 namespace input {
     struct Keybinds {
         i32 move_pz, move_nz;
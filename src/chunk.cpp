@@ -1,180 +1,70 @@
 #include <cstring>
-#include <daxa/types.hpp>
-#include <daxa/utils/math_operators.hpp>
 
 #include "chunk.hpp"
-#include "shared.inl"
 
-using namespace daxa::math_operators;
-
-static constexpr inline u32 CUBE_VERTS = 36;
-static constexpr inline u32 CUBE_VERTS_SIZE = CUBE_VERTS * sizeof(Vertex);
-static constexpr inline u32 CHUNK_VERTS = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * CUBE_VERTS;
-static constexpr inline u32 CHUNK_VERTS_SIZE = CHUNK_VERTS * sizeof(Vertex);
-
-Chunk::Chunk(daxa::Device _device, const glm::ivec3 &_chunkPos, const FastNoise::SmartNode<> &generator) : device{
-        _device}, pos{_chunkPos} {
-    std::vector<float> noiseOutput(16 * 16 * 16);
-    generator->GenUniformGrid3D(noiseOutput.data(), 16 * pos.z, 16 * pos.y, 16 * pos.x, 16, 16, 16, 0.05f, 1337);
-
-    std::vector<Vertex> vertices;
-    vertices.reserve(CHUNK_VERTS);
-
-    int index = 0;
-
-    for (u32 x = 0; x < CHUNK_SIZE; x++) {
-        for (u32 y = 0; y < CHUNK_SIZE; y++) {
-            for (u32 z = 0; z < CHUNK_SIZE; z++) {
-                if (noiseOutput[index++] <= 0.0f) {
-                    blockIds[x][y][z] = BlockID::Stone;
-                } else {
-                    blockIds[x][y][z] = BlockID::Air;
-                }
-            }
-        }
+daxa::BufferId createQuadIndexBuffer(daxa::Device &device) {
+    std::vector<u32> indices(MAX_CHUNK_QUADS * 6);
+    for (u32 quad = 0; quad < MAX_CHUNK_QUADS; quad++) {
+        const u32 base = quad * 4;
+        const std::array<u32, 6> quadIndices = { base + 0, base + 1, base + 2, base + 2, base + 3, base + 0 };
+        std::memcpy(&indices[quad * 6], quadIndices.data(), sizeof(quadIndices));
     }
 
-    for(u32 x = 0; x < CHUNK_SIZE; x++) {
-        for(u32 y = 0; y < CHUNK_SIZE; y++) {
-            for(u32 z = 0; z < CHUNK_SIZE; z++) {
-                if(blockIds[x][y][z] != BlockID::Stone) { continue; }
-                f32 f_x = static_cast<f32>(x);
-                f32 f_y = static_cast<f32>(y);
-                f32 f_z = static_cast<f32>(z);
-
-                f32 r = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-                f32 g = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-                f32 b = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-
-                f32vec3 col = {r, g, b};
-                glm::ivec3 voxel_pos = { x, y, z };
-
-                std::vector<Vertex> block_verts = {};
-
-                u32 id = 4;
-
-                if(getVoxel(voxel_pos + glm::ivec3{ 0, 0, -1 }) == BlockID::Air) {
-                    std::vector<Vertex> face = {
-                            Vertex {{-0.5f + f_x, -0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 0.0f } },
-                            Vertex {{ 0.5f + f_x, -0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 0.0f } },
-                            Vertex {{ 0.5f + f_x,  0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 1.0f } },
-                            Vertex {{ 0.5f + f_x,  0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 1.0f } },
-                            Vertex {{-0.5f + f_x,  0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 1.0f } },
-                            Vertex {{-0.5f + f_x, -0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 0.0f } },
-                    };
+    const u32 size = static_cast<u32>(indices.size() * sizeof(u32));
+    daxa::BufferId indexBuffer = device.create_buffer(
+            {.size = size, .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY, .name = "quad index buffer"});
 
-                    block_verts.insert(block_verts.end(), face.begin(), face.end());
-                }
-
-                if(getVoxel(voxel_pos + glm::ivec3{ 0, 0, +1 }) == BlockID::Air) {
-                    std::vector<Vertex> face = {
-                            Vertex {{-0.5f + f_x, -0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 0.0f } },
-                            Vertex {{ 0.5f + f_x, -0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 0.0f } },
-                            Vertex {{ 0.5f + f_x,  0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 1.0f } },
-                            Vertex {{ 0.5f + f_x,  0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 1.0f } },
-                            Vertex {{-0.5f + f_x,  0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 1.0f } },
-                            Vertex {{-0.5f + f_x, -0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 0.0f } },
-                    };
-
-                    block_verts.insert(block_verts.end(), face.begin(), face.end());
-                }
-
-                if(getVoxel(voxel_pos + glm::ivec3{ -1, 0, 0 }) == BlockID::Air) {
-                    std::vector<Vertex> face = {
-                            Vertex {{-0.5f + f_x,  0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 0.0f } },
-                            Vertex {{-0.5f + f_x,  0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 1.0f } },
-                            Vertex {{-0.5f + f_x, -0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 1.0f } },
-                            Vertex {{-0.5f + f_x, -0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 1.0f } },
-                            Vertex {{-0.5f + f_x, -0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 0.0f } },
-                            Vertex {{-0.5f + f_x,  0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 0.0f } },
-                    };
-
-                    block_verts.insert(block_verts.end(), face.begin(), face.end());
-                }
-
-                if(getVoxel(voxel_pos + glm::ivec3{ +1, 0, 0 }) == BlockID::Air) {
-                    std::vector<Vertex> face = {
-                            Vertex {{ 0.5f + f_x,  0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 0.0f } },
-                            Vertex {{ 0.5f + f_x,  0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 1.0f } },
-                            Vertex {{ 0.5f + f_x, -0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 1.0f } },
-                            Vertex {{ 0.5f + f_x, -0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 1.0f } },
-                            Vertex {{ 0.5f + f_x, -0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 0.0f } },
-                            Vertex {{ 0.5f + f_x,  0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 0.0f } },
-                    };
-
-                    block_verts.insert(block_verts.end(), face.begin(), face.end());
-                }
+    daxa::BufferId staging_buffer = device.create_buffer(
+            {.size = size, .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,});
 
-                if(getVoxel(voxel_pos + glm::ivec3{ 0, -1, 0 }) == BlockID::Air) {
-                    std::vector<Vertex> face = {
-                            Vertex {{-0.5f + f_x, -0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 1.0f } },
-                            Vertex {{ 0.5f + f_x, -0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 1.0f } },
-                            Vertex {{ 0.5f + f_x, -0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 0.0f } },
-                            Vertex {{ 0.5f + f_x, -0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 0.0f } },
-                            Vertex {{-0.5f + f_x, -0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 0.0f } },
-                            Vertex {{-0.5f + f_x, -0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 1.0f } },
-                    };
+    std::memcpy(device.get_host_address_as<u32>(staging_buffer), indices.data(), size);
 
-                    block_verts.insert(block_verts.end(), face.begin(), face.end());
-                }
+    daxa::CommandList command_list = device.create_command_list({.name = "quad index upload"});
+    command_list.copy_buffer_to_buffer({.src_buffer = staging_buffer, .dst_buffer = indexBuffer, .size = size});
+    command_list.complete();
+    device.submit_commands({.command_lists = {std::move(command_list)},});
+    device.wait_idle();
+    device.destroy_buffer(staging_buffer);
 
-                if(getVoxel(voxel_pos + glm::ivec3{ 0, +1, 0 }) == BlockID::Air) {
-                    std::vector<Vertex> face = {
-                            Vertex {{-0.5f + f_x,  0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 1.0f } },
-                            Vertex {{ 0.5f + f_x,  0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 1.0f } },
-                            Vertex {{ 0.5f + f_x,  0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 0.0f } },
-                            Vertex {{ 0.5f + f_x,  0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 1.0f, 0.0f } },
-                            Vertex {{-0.5f + f_x,  0.5f + f_y,  0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 0.0f } },
-                            Vertex {{-0.5f + f_x,  0.5f + f_y, -0.5f + f_z},      { col.x, col.y, col.z }, id, { 0.0f, 1.0f } },
-                    };
+    return indexBuffer;
+}
 
-                    block_verts.insert(block_verts.end(), face.begin(), face.end());
-                }
+Chunk::Chunk(MeshArena &_arena, const glm::ivec3 &_chunkPos) : arena{_arena}, pos{_chunkPos} {}
 
-                vertices.insert(vertices.end(), block_verts.begin(), block_verts.end());
-            }
-        }
+bool Chunk::uploadMesh(const ChunkMesh &mesh, UploadManager &uploads, ChunkDrawList &drawList) {
+    if (!uploads.canStage(UploadManager::alignedSize(mesh.byteSize()) + UploadManager::alignedSize(sizeof(ChunkDescriptor)))) {
+        return false;
     }
 
+    arena.free(allocation);
+    allocation = {};
 
-    std::cout << vertices.size() << std::endl;
-    chunkSize = vertices.size();
-    renderable = chunkSize != 0;
-
-    this->faceBuffer = device.create_buffer(
-            {.size = CHUNK_VERTS_SIZE, .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,});
-
-    daxa::BufferId staging_buffer = device.create_buffer(
-            {.size = CHUNK_VERTS_SIZE, .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,});
-
-    auto *buffer_ptr = device.get_host_address_as<Vertex>(staging_buffer);
-
-    std::memcpy(buffer_ptr, vertices.data(), CHUNK_VERTS_SIZE);
+    backend = mesh.backend;
+    quadCount = mesh.quadCount;
+    faceQuadCounts = mesh.faceQuadCounts;
+    lod = mesh.lod;
+    meshTime = mesh.meshTime;
+    renderable = quadCount != 0;
 
-    daxa::CommandList command_list = device.create_command_list({.name = "my command list"});
-
-    command_list.copy_buffer_to_buffer(
-            {.src_buffer = staging_buffer, .dst_buffer = faceBuffer, .size = CHUNK_VERTS_SIZE});
+    // empty chunks don't take any space in the arena
+    if (renderable) {
+        allocation = arena.allocate(mesh.byteSize());
+        uploads.stage(arena.buffer, allocation.offset, mesh.data(), mesh.byteSize());
+    }
 
-    command_list.complete();
-    device.submit_commands({.command_lists = {std::move(command_list)},});
-    device.wait_idle();
-    device.destroy_buffer(staging_buffer);
+    daxa::BufferDeviceAddress meshAddress = arena.device.get_device_address(arena.buffer) + allocation.offset;
+    drawList.writeSlot(drawSlot, ChunkDescriptor {
+        .position = *reinterpret_cast<const i32vec3 *>(&pos),
+        .quadCount = quadCount,
+        .vertices = meshAddress,
+        .faces = meshAddress,
+        .backend = backend == MeshBackend::Faces ? CHUNK_BACKEND_FACES : CHUNK_BACKEND_VERTICES,
+        .faceQuadCounts = {faceQuadCounts[0], faceQuadCounts[1], faceQuadCounts[2], faceQuadCounts[3], faceQuadCounts[4], faceQuadCounts[5]},
+        .lod = lod,
+    }, uploads);
+    return true;
 }
 
 Chunk::~Chunk() {
-    device.destroy_buffer(faceBuffer);
-}
-
-BlockID Chunk::getVoxel(const glm::ivec3 &p) {
-    if(p.x < 0 || p.x >= CHUNK_SIZE) {
-        return BlockID::Air;
-    }
-    if(p.y < 0 || p.y >= CHUNK_SIZE) {
-        return BlockID::Air;
-    }
-    if(p.z < 0 || p.z >= CHUNK_SIZE) {
-        return BlockID::Air;
-    }
-    return blockIds[p.x][p.y][p.z];
+    arena.free(allocation);
 }
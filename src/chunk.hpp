@@ -1,34 +1,49 @@
 #pragma once
 
-#include <array>
+#include <optional>
 #include <daxa/daxa.hpp>
-#include <daxa/device.hpp>
 #include <glm/glm.hpp>
-#include <FastNoise/FastNoise.h>
+
+#include "voxels.hpp"
+#include "mesher.hpp"
+#include "mesh_arena.hpp"
+#include "upload.hpp"
+#include "draw_list.hpp"
 
 using namespace daxa::types;
 
-static constexpr i32 CHUNK_SIZE = 16;
+// the headless benchmark's world spans -WORLD_SIZE to +WORLD_SIZE chunks on each axis,
+// the windowed app streams chunks around the camera instead
+static constexpr i32 WORLD_SIZE_X = 16;
+static constexpr i32 WORLD_SIZE_Y = 1;
+static constexpr i32 WORLD_SIZE_Z = 16;
 
-enum struct BlockID: u32 {
-    Air,
-    Grass, 
-    Dirt,
-    Stone
-};
+daxa::BufferId createQuadIndexBuffer(daxa::Device &device);
 
+// a loaded chunk, its voxels and the range of the mesh arena its mesh lives in
 struct Chunk {
-    Chunk(daxa::Device _device, const glm::ivec3& _chunkPos, const FastNoise::SmartNode<> &generator);
+    Chunk(MeshArena &_arena, const glm::ivec3& _chunkPos);
     ~Chunk();
 
-    BlockID getVoxel(const glm::ivec3 &p);
+    // stages the mesh into the arena, replacing the previous one, and points the chunk's draw slot at it,
+    // main thread only, returns false when this frame's upload budget is used up
+    bool uploadMesh(const ChunkMesh &mesh, UploadManager &uploads, ChunkDrawList &drawList);
 
-    daxa::BufferId faceBuffer;
-    u32 chunkSize;
-    daxa::Device &device;
+    MeshAllocation allocation = {};
+    MeshBackend backend = MeshBackend::Vertices;
+    u32 quadCount = 0;
+    std::array<u32, 6> faceQuadCounts = {};
+    MeshArena &arena;
     bool renderable = false;
+    u32 lod = 0; // of the uploaded mesh
+    // lod of the last mesh handed to the workers, empty while the chunk waits in the mesh queue
+    std::optional<u32> scheduledLod = std::nullopt;
+    // generation of the last mesh handed to the workers, a finished mesh from an older one is stale and isn't uploaded
+    u64 meshGeneration = 0;
     glm::ivec3 pos = {};
+    u32 drawSlot = 0; // handed out when the chunk is added to the world
+    f64 meshTime = 0.0; // milliseconds
+    bool dirty = false; // the voxels aren't in the region files yet
 
-    std::array<std::array<std::array<BlockID, 16>, 16>, 16> blockIds = {};
+    ChunkVoxels voxels = {};
 };
-
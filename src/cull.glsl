@@ -0,0 +1,107 @@
+#include "shared.inl"
+
+DAXA_DECL_PUSH_CONSTANT(CullPush, push)
+
+layout(local_size_x = 64) in;
+
+// true when the box was completely behind the depth of the previous frame
+bool occluded(CullParams params, f32vec3 boxMin, f32vec3 boxMax) {
+  f32vec2 uvMin = f32vec2(1.0);
+  f32vec2 uvMax = f32vec2(0.0);
+  f32 nearestDepth = 1.0;
+  for (u32 i = 0u; i < 8u; i++) {
+    f32vec3 corner = mix(boxMin, boxMax, bvec3((i & 1u) != 0u, (i & 2u) != 0u, (i & 4u) != 0u));
+    f32vec4 clip = params.occlusionViewProjection * f32vec4(corner, 1.0);
+    // a corner behind the camera, the box can't be tested against the screen
+    if (clip.w <= 0.0) {
+      return false;
+    }
+    f32vec3 ndc = clip.xyz / clip.w;
+    uvMin = min(uvMin, ndc.xy * 0.5 + 0.5);
+    uvMax = max(uvMax, ndc.xy * 0.5 + 0.5);
+    nearestDepth = min(nearestDepth, ndc.z);
+  }
+
+  uvMin = clamp(uvMin, 0.0, 1.0);
+  uvMax = clamp(uvMax, 0.0, 1.0);
+  i32vec2 levelSize = i32vec2(params.hizSize);
+  i32vec2 texelMin = min(i32vec2(uvMin * f32vec2(levelSize)), levelSize - 1);
+  i32vec2 texelMax = min(i32vec2(uvMax * f32vec2(levelSize)), levelSize - 1);
+
+  // the level at which the box spans at most 2x2 texels
+  i32 span = max(texelMax.x - texelMin.x, texelMax.y - texelMin.y);
+  i32 level = min(span == 0 ? 0 : findMSB(span) + 1, i32(params.hizLevelCount) - 1);
+  levelSize = max(levelSize >> level, i32vec2(1));
+  texelMin = min(texelMin >> level, levelSize - 1);
+  texelMax = min(texelMax >> level, levelSize - 1);
+
+  daxa_ImageViewId hiz = params.hiz;
+  f32 furthestDepth = max(
+      max(texelFetch(daxa_texture2D(hiz), texelMin, level).r, texelFetch(daxa_texture2D(hiz), i32vec2(texelMax.x, texelMin.y), level).r),
+      max(texelFetch(daxa_texture2D(hiz), i32vec2(texelMin.x, texelMax.y), level).r, texelFetch(daxa_texture2D(hiz), texelMax, level).r));
+  return nearestDepth > furthestDepth;
+}
+
+// one invocation per descriptor slot, visible chunks append a draw for every face bucket that can face the camera
+void main() {
+  u32 slot = gl_GlobalInvocationID.x;
+  if (slot >= push.slotCount) {
+    return;
+  }
+
+  ChunkDescriptor chunk = deref(push.chunks[slot]);
+  if (chunk.quadCount == 0) {
+    return;
+  }
+
+  CullParams params = deref(push.params);
+
+  // vertices sit half a block below their block corners, chunks are 16 blocks wide
+  f32vec3 boxMin = f32vec3(chunk.position * 16) - 0.5;
+  f32vec3 boxMax = boxMin + 16.0;
+  for (u32 i = 0u; i < 6u; i++) {
+    f32vec4 plane = params.frustumPlanes[i];
+    // the corner furthest along the plane normal
+    f32vec3 corner = mix(boxMin, boxMax, greaterThanEqual(plane.xyz, f32vec3(0.0)));
+    if (dot(plane.xyz, corner) + plane.w < 0.0) {
+      atomicAdd(deref(push.draws).culledCount, 1u);
+      return;
+    }
+  }
+
+  if (params.occlusion != 0u && occluded(params, boxMin, boxMax)) {
+    atomicAdd(deref(push.draws).occludedCount, 1u);
+    return;
+  }
+
+  // a bucket can only face the camera when the camera is on the outer side of the bucket's lowest or highest plane
+  bool bucketVisible[6] = bool[6](
+      params.cameraPosition.x < boxMax.x, params.cameraPosition.x > boxMin.x,
+      params.cameraPosition.y < boxMax.y, params.cameraPosition.y > boxMin.y,
+      params.cameraPosition.z < boxMax.z, params.cameraPosition.z > boxMin.z);
+
+  u32 drawCount = 0u;
+  for (u32 face = 0u; face < 6u; face++) {
+    if (bucketVisible[face] && chunk.faceQuadCounts[face] != 0u) {
+      drawCount++;
+    }
+  }
+
+  u32 index = chunk.backend == CHUNK_BACKEND_FACES
+      ? atomicAdd(deref(push.draws).faceDrawCount, drawCount)
+      : atomicAdd(deref(push.draws).vertexDrawCount, drawCount);
+
+  u32 firstQuad = 0u;
+  for (u32 face = 0u; face < 6u; face++) {
+    u32 quadCount = chunk.faceQuadCounts[face];
+    if (bucketVisible[face] && quadCount != 0u) {
+      if (chunk.backend == CHUNK_BACKEND_FACES) {
+        deref(push.draws).faceDraws[index] = DrawCommand(quadCount * 6u, 1u, firstQuad * 6u, slot);
+      } else {
+        deref(push.draws).vertexDraws[index] = DrawIndexedCommand(quadCount * 6u, 1u, firstQuad * 6u, 0, slot);
+      }
+      index++;
+    }
+    firstQuad += quadCount;
+  }
+}
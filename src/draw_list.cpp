@@ -0,0 +1,167 @@
+#include <cstddef>
+#include <stdexcept>
+
+#include "draw_list.hpp"
+
+// the counts at the start of CullOutput
+static constexpr u32 CULL_COUNTS_SIZE = 4 * sizeof(u32);
+static constexpr u32 CULL_GROUP_SIZE = 64;
+// the swapchain lets at most two frames be in flight, a third entry is the one being written
+static constexpr u32 CULL_PARAMS_FRAMES = 3;
+
+ChunkDrawList::ChunkDrawList(daxa::Device &_device, daxa::PipelineManager &pipelineManager) : device{_device} {
+    this->descriptorBuffer = device.create_buffer({
+        .size = sizeof(ChunkDescriptor) * MAX_CHUNK_SLOTS,
+        .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
+        .name = "chunk descriptors",
+    });
+    this->cullBuffer = device.create_buffer({
+        .size = sizeof(CullOutput),
+        .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
+        .name = "chunk draws",
+    });
+    this->paramsBuffer = device.create_buffer({
+        .size = sizeof(CullParams) * CULL_PARAMS_FRAMES,
+        .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_SEQUENTIAL_WRITE,
+        .name = "cull params",
+    });
+    this->readbackBuffer = device.create_buffer({
+        .size = CULL_COUNTS_SIZE,
+        .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_RANDOM,
+        .name = "chunk draw counts readback",
+    });
+
+    this->cullPipeline = pipelineManager.add_compute_pipeline(daxa::ComputePipelineCompileInfo {
+        .shader_info = daxa::ShaderCompileInfo {
+            .source = daxa::ShaderSource { daxa::ShaderFile { .path = "src/cull.glsl" }, },
+        },
+        .push_constant_size = sizeof(CullPush),
+        .name = "cull pipeline",
+    }).value();
+
+    // slots are culled as soon as they are handed out, before their first mesh is written
+    daxa::CommandList command_list = device.create_command_list({.name = "chunk descriptor clear"});
+    command_list.clear_buffer({
+        .buffer = descriptorBuffer,
+        .offset = 0,
+        .size = sizeof(ChunkDescriptor) * MAX_CHUNK_SLOTS,
+        .clear_value = 0,
+    });
+    command_list.complete();
+    device.submit_commands({.command_lists = {std::move(command_list)},});
+    device.wait_idle();
+}
+
+ChunkDrawList::~ChunkDrawList() {
+    device.destroy_buffer(descriptorBuffer);
+    device.destroy_buffer(cullBuffer);
+    device.destroy_buffer(paramsBuffer);
+    device.destroy_buffer(readbackBuffer);
+}
+
+u32 ChunkDrawList::allocateSlot() {
+    if (!freeSlots.empty()) {
+        u32 slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+    if (slotCount == MAX_CHUNK_SLOTS) {
+        throw std::runtime_error("chunk draw list is out of slots");
+    }
+    return slotCount++;
+}
+
+void ChunkDrawList::freeSlot(u32 slot) {
+    freeSlots.push_back(slot);
+}
+
+void ChunkDrawList::writeSlot(u32 slot, const ChunkDescriptor &descriptor, UploadManager &uploads) {
+    uploads.stage(descriptorBuffer, slot * static_cast<u32>(sizeof(ChunkDescriptor)), &descriptor, sizeof(ChunkDescriptor));
+}
+
+void ChunkDrawList::cull(daxa::CommandList &cmd_list, const Frustum &frustum, const glm::vec3 &cameraPosition,
+                         const HiZPyramid &hiz, const glm::mat4 &occlusionViewProjection, u64 frame) {
+    const u32 paramsOffset = static_cast<u32>(frame % CULL_PARAMS_FRAMES) * static_cast<u32>(sizeof(CullParams));
+    CullParams &params = *reinterpret_cast<CullParams *>(device.get_host_address_as<u8>(paramsBuffer) + paramsOffset);
+    for (u32 i = 0; i < 6; i++) {
+        params.frustumPlanes[i] = *reinterpret_cast<const f32vec4 *>(&frustum.planes[i]);
+    }
+    params.cameraPosition = *reinterpret_cast<const f32vec3 *>(&cameraPosition);
+    params.occlusionViewProjection = *reinterpret_cast<const f32mat4x4 *>(&occlusionViewProjection);
+    params.hiz = hiz.image.default_view();
+    params.hizSize = {hiz.width, hiz.height};
+    params.hizLevelCount = hiz.levelCount;
+    params.occlusion = hiz.valid ? 1 : 0;
+
+    // the previous frame may still be drawing from the counts
+    cmd_list.pipeline_barrier({
+        .src_access = daxa::AccessConsts::READ,
+        .dst_access = daxa::AccessConsts::TRANSFER_WRITE,
+    });
+    cmd_list.clear_buffer({
+        .buffer = cullBuffer,
+        .offset = 0,
+        .size = CULL_COUNTS_SIZE,
+        .clear_value = 0,
+    });
+    cmd_list.pipeline_barrier({
+        .src_access = daxa::AccessConsts::TRANSFER_WRITE,
+        .dst_access = daxa::AccessConsts::COMPUTE_SHADER_READ_WRITE,
+    });
+
+    cmd_list.set_pipeline(*cullPipeline);
+    cmd_list.push_constant(CullPush {
+        .params = device.get_device_address(paramsBuffer) + paramsOffset,
+        .chunks = device.get_device_address(descriptorBuffer),
+        .draws = device.get_device_address(cullBuffer),
+        .slotCount = slotCount,
+    });
+    cmd_list.dispatch((slotCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    cmd_list.pipeline_barrier({
+        .src_access = daxa::AccessConsts::COMPUTE_SHADER_WRITE,
+        .dst_access = daxa::AccessConsts::READ,
+    });
+    cmd_list.copy_buffer_to_buffer({
+        .src_buffer = cullBuffer,
+        .dst_buffer = readbackBuffer,
+        .size = CULL_COUNTS_SIZE,
+    });
+}
+
+void ChunkDrawList::drawVertices(daxa::CommandList &cmd_list) {
+    cmd_list.draw_indirect_count({
+        .draw_command_buffer = cullBuffer,
+        .draw_command_buffer_read_offset = offsetof(CullOutput, vertexDraws),
+        .draw_count_buffer = cullBuffer,
+        .draw_count_buffer_read_offset = offsetof(CullOutput, vertexDrawCount),
+        .max_draw_count = MAX_CHUNK_DRAWS,
+        .draw_command_stride = sizeof(DrawIndexedCommand),
+        .is_indexed = true,
+    });
+}
+
+void ChunkDrawList::drawFaces(daxa::CommandList &cmd_list) {
+    cmd_list.draw_indirect_count({
+        .draw_command_buffer = cullBuffer,
+        .draw_command_buffer_read_offset = offsetof(CullOutput, faceDraws),
+        .draw_count_buffer = cullBuffer,
+        .draw_count_buffer_read_offset = offsetof(CullOutput, faceDrawCount),
+        .max_draw_count = MAX_CHUNK_DRAWS,
+        .draw_command_stride = sizeof(DrawCommand),
+        .is_indexed = false,
+    });
+}
+
+u32 ChunkDrawList::drawCount() {
+    const u32 *counts = device.get_host_address_as<u32>(readbackBuffer);
+    return counts[0] + counts[1];
+}
+
+u32 ChunkDrawList::culledCount() {
+    return device.get_host_address_as<u32>(readbackBuffer)[2];
+}
+
+u32 ChunkDrawList::occludedCount() {
+    return device.get_host_address_as<u32>(readbackBuffer)[3];
+}
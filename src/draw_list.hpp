@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <daxa/daxa.hpp>
+#include <daxa/utils/pipeline_manager.hpp>
+
+#include "shared.inl"
+#include "camera.hpp"
+#include "upload.hpp"
+#include "hiz.hpp"
+
+// the GPU side list of chunks: one descriptor slot per loaded chunk in a device-local buffer,
+// a compute pass culls every slot against the frustum and writes the frame's indirect draws
+struct ChunkDrawList {
+    ChunkDrawList(daxa::Device &_device, daxa::PipelineManager &pipelineManager);
+    ~ChunkDrawList();
+
+    // throws when all MAX_CHUNK_SLOTS slots are taken
+    u32 allocateSlot();
+    // the slot has to be cleared through writeSlot before it is freed
+    void freeSlot(u32 slot);
+    void writeSlot(u32 slot, const ChunkDescriptor &descriptor, UploadManager &uploads);
+
+    // has to be recorded outside of a renderpass, resets the draws and culls every slot in use against the frustum
+    // and against the depth pyramid of the previous frame, seen through that frame's view projection,
+    // visible chunks get one draw per face bucket that can face the camera
+    void cull(daxa::CommandList &cmd_list, const Frustum &frustum, const glm::vec3 &cameraPosition,
+              const HiZPyramid &hiz, const glm::mat4 &occlusionViewProjection, u64 frame);
+    // one draw_indirect_count per backend, the caller binds the matching pipeline and index buffer
+    void drawVertices(daxa::CommandList &cmd_list);
+    void drawFaces(daxa::CommandList &cmd_list);
+
+    // counts written by a recent frame, only meant for stats
+    u32 drawCount(); // face bucket draws, not chunks
+    u32 culledCount();
+    u32 occludedCount();
+
+    daxa::Device &device;
+    daxa::BufferId descriptorBuffer;
+    daxa::BufferId cullBuffer;
+    daxa::BufferId paramsBuffer;
+    daxa::BufferId readbackBuffer; // the counts of cullBuffer, copied every frame
+    std::shared_ptr<daxa::ComputePipeline> cullPipeline;
+    std::vector<u32> freeSlots = {};
+    u32 slotCount = 0; // slots ever handed out, the cull pass runs over all of them
+};
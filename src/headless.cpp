@@ -0,0 +1,183 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+#include "headless.hpp"
+#include "chunk.hpp"
+#include "jobs.hpp"
+#include "mesher.hpp"
+#include "terrain.hpp"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include "glm/gtx/hash.hpp"
+
+static f64 millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// generates the whole world on one thread chunk by chunk and in batches of batchSize chunks, in voxels per second
+static void benchmarkGeneration(const WorldGenerator &generator, const glm::ivec3 &batchSize) {
+    const glm::ivec3 worldMin = {-WORLD_SIZE_X, -WORLD_SIZE_Y, -WORLD_SIZE_Z};
+    const glm::ivec3 worldChunks = glm::ivec3{WORLD_SIZE_X, WORLD_SIZE_Y, WORLD_SIZE_Z} * 2 + 1;
+    std::vector<ChunkVoxels> voxels(static_cast<usize>(worldChunks.x * worldChunks.y * worldChunks.z));
+    const f64 voxelCount = static_cast<f64>(voxels.size()) * CHUNK_VOLUME;
+
+    auto start = std::chrono::steady_clock::now();
+    for (i32 z = 0; z < worldChunks.z; z++) {
+        for (i32 y = 0; y < worldChunks.y; y++) {
+            for (i32 x = 0; x < worldChunks.x; x++) {
+                generator.generate(voxels[static_cast<usize>((z * worldChunks.y + y) * worldChunks.x + x)], worldMin + glm::ivec3{x, y, z});
+            }
+        }
+    }
+    const f64 singleTime = millisecondsSince(start);
+
+    // batches are clamped at the edges of the world
+    start = std::chrono::steady_clock::now();
+    std::vector<ChunkVoxels *> batch = {};
+    u32 densityChunks = 0;
+    for (i32 bz = 0; bz < worldChunks.z; bz += batchSize.z) {
+        for (i32 by = 0; by < worldChunks.y; by += batchSize.y) {
+            for (i32 bx = 0; bx < worldChunks.x; bx += batchSize.x) {
+                const glm::ivec3 first = {bx, by, bz};
+                const glm::ivec3 count = glm::min(batchSize, worldChunks - first);
+                batch.clear();
+                for (i32 z = 0; z < count.z; z++) {
+                    for (i32 y = 0; y < count.y; y++) {
+                        for (i32 x = 0; x < count.x; x++) {
+                            const glm::ivec3 p = first + glm::ivec3{x, y, z};
+                            batch.push_back(&voxels[static_cast<usize>((p.z * worldChunks.y + p.y) * worldChunks.x + p.x)]);
+                        }
+                    }
+                }
+                densityChunks += generator.generateBatch(batch, worldMin + first, count);
+            }
+        }
+    }
+    const f64 batchTime = millisecondsSince(start);
+
+    std::cout << "generation of " << voxels.size() << " chunks on 1 thread: " << voxelCount / singleTime / 1000.0
+              << " Mvoxels/s per chunk, " << voxelCount / batchTime / 1000.0 << " Mvoxels/s in " << batchSize.x << "x"
+              << batchSize.y << "x" << batchSize.z << " chunk batches (" << singleTime / batchTime << "x), "
+              << densityChunks << " chunks needed the 3D density" << std::endl;
+}
+
+// meshes the whole world on one thread into a fresh mesh per chunk, which grows its buffers quad by quad,
+// and into one reused mesh with worst case capacity, in chunks per second
+static void benchmarkMeshing(const WorldGenerator &generator) {
+    std::unordered_map<glm::ivec3, ChunkVoxels> voxels = {};
+    for (i32 x = -WORLD_SIZE_X; x <= WORLD_SIZE_X; x++) {
+        for (i32 y = -WORLD_SIZE_Y; y <= WORLD_SIZE_Y; y++) {
+            for (i32 z = -WORLD_SIZE_Z; z <= WORLD_SIZE_Z; z++) {
+                generator.generate(voxels[glm::ivec3{x, y, z}], {x, y, z});
+            }
+        }
+    }
+    std::vector<PaddedVoxels> padded = {};
+    padded.reserve(voxels.size());
+    for (auto &[chunkPos, chunkVoxels] : voxels) {
+        std::array<const ChunkVoxels *, 6> neighbors = {};
+        for (u32 face = 0; face < 6; face++) {
+            auto neighbor = voxels.find(chunkPos + FACE_NORMALS[face]);
+            neighbors[face] = neighbor != voxels.end() ? &neighbor->second : nullptr;
+        }
+        padded.emplace_back(chunkVoxels, neighbors);
+    }
+
+    for (MesherType mesher : {MesherType::Greedy, MesherType::Naive}) {
+        for (MeshBackend backend : {MeshBackend::Vertices, MeshBackend::Faces}) {
+            u64 quadAmount = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (const PaddedVoxels &chunk : padded) {
+                ChunkMesh mesh = {};
+                meshChunk(chunk, mesher, backend, 0, mesh);
+                quadAmount += mesh.quadCount;
+            }
+            const f64 freshTime = millisecondsSince(start);
+
+            ChunkMesh mesh = {};
+            mesh.reserveWorstCase();
+            start = std::chrono::steady_clock::now();
+            for (const PaddedVoxels &chunk : padded) {
+                meshChunk(chunk, mesher, backend, 0, mesh);
+            }
+            const f64 reusedTime = millisecondsSince(start);
+
+            const f64 chunkCount = static_cast<f64>(padded.size());
+            std::cout << (mesher == MesherType::Greedy ? "greedy" : "naive") << " meshing of " << padded.size() << " chunks ("
+                      << quadAmount << " quads) on 1 thread, " << (backend == MeshBackend::Faces ? "face" : "vertex") << " backend: "
+                      << chunkCount / freshTime * 1000.0 << " chunks/s into fresh meshes, "
+                      << chunkCount / reusedTime * 1000.0 << " chunks/s into a reused buffer" << std::endl;
+        }
+    }
+}
+
+void runHeadlessBenchmark() {
+    const WorldGenerator generator{};
+
+    // a column of chunks and a larger box, the windowed app batches columns
+    benchmarkGeneration(generator, {1, WORLD_SIZE_Y * 2 + 1, 1});
+    benchmarkGeneration(generator, {4, WORLD_SIZE_Y * 2 + 1, 4});
+    benchmarkMeshing(generator);
+
+    const u32 maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    f64 singleThreadTime = 0.0;
+
+    for (u32 threadCount = 1;; threadCount = std::min(threadCount * 2, maxThreads)) {
+        JobSystem jobs{threadCount};
+        std::atomic<u64> quadAmount = 0;
+        // summed over all workers, in microseconds
+        std::atomic<u64> generateTime = 0;
+        std::atomic<u64> meshTime = 0;
+        u32 chunkAmount = 0;
+
+        // every chunk is generated before meshing starts so each mesh sees its neighbours
+        std::unordered_map<glm::ivec3, ChunkVoxels> voxels = {};
+        for (i32 x = -WORLD_SIZE_X; x <= WORLD_SIZE_X; x++) {
+            for (i32 y = -WORLD_SIZE_Y; y <= WORLD_SIZE_Y; y++) {
+                for (i32 z = -WORLD_SIZE_Z; z <= WORLD_SIZE_Z; z++) {
+                    voxels[glm::ivec3{x, y, z}] = {};
+                    chunkAmount++;
+                }
+            }
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (auto &[chunkPos, chunkVoxels] : voxels) {
+            jobs.schedule([&, chunkPos = chunkPos] {
+                auto generateStart = std::chrono::steady_clock::now();
+                generator.generate(chunkVoxels, chunkPos);
+                generateTime += static_cast<u64>(millisecondsSince(generateStart) * 1000.0);
+            });
+        }
+        jobs.wait();
+
+        for (auto &[chunkPos, chunkVoxels] : voxels) {
+            std::array<const ChunkVoxels *, 6> neighbors = {};
+            for (u32 face = 0; face < 6; face++) {
+                auto neighbor = voxels.find(chunkPos + FACE_NORMALS[face]);
+                neighbors[face] = neighbor != voxels.end() ? &neighbor->second : nullptr;
+            }
+            jobs.schedule([&, padded = PaddedVoxels{chunkVoxels, neighbors}] {
+                ChunkMesh mesh = meshChunk(padded, MesherType::Greedy, MeshBackend::Vertices);
+                meshTime += static_cast<u64>(mesh.meshTime * 1000.0);
+                quadAmount += mesh.quadCount;
+            });
+        }
+        jobs.wait();
+        f64 time = millisecondsSince(start);
+
+        if (threadCount == 1) {
+            singleThreadTime = time;
+        }
+        std::cout << threadCount << " threads: " << chunkAmount << " chunks, " << quadAmount.load() << " quads in "
+                  << time << " ms, " << singleThreadTime / time << "x speedup (generation "
+                  << static_cast<f64>(generateTime.load()) / 1000.0 << " ms, meshing "
+                  << static_cast<f64>(meshTime.load()) / 1000.0 << " ms of thread time)" << std::endl;
+
+        if (threadCount == maxThreads) { break; }
+    }
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// compares per chunk and batched terrain generation and greedy and naive meshing into fresh and reused buffers, then generates
+// and meshes the whole world for 1, 2, 4, ... threads and prints the timings, needs neither a window nor a GPU
+void runHeadlessBenchmark();
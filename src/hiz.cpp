@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <bit>
+
+#include "hiz.hpp"
+
+static constexpr u32 HIZ_GROUP_SIZE = 8;
+
+HiZPyramid::HiZPyramid(daxa::Device &_device, daxa::PipelineManager &pipelineManager, u32 _depthWidth, u32 _depthHeight) : device{_device} {
+    this->buildPipeline = pipelineManager.add_compute_pipeline(daxa::ComputePipelineCompileInfo {
+        .shader_info = daxa::ShaderCompileInfo {
+            .source = daxa::ShaderSource { daxa::ShaderFile { .path = "src/hiz.glsl" }, },
+        },
+        .push_constant_size = sizeof(HiZPush),
+        .name = "hiz pipeline",
+    }).value();
+
+    create(_depthWidth, _depthHeight);
+}
+
+HiZPyramid::~HiZPyramid() {
+    destroy();
+}
+
+void HiZPyramid::create(u32 _depthWidth, u32 _depthHeight) {
+    depthWidth = _depthWidth;
+    depthHeight = _depthHeight;
+    width = std::max(1u, depthWidth / 2);
+    height = std::max(1u, depthHeight / 2);
+    levelCount = static_cast<u32>(std::bit_width(std::max(width, height)));
+
+    image = device.create_image({
+        .format = daxa::Format::R32_SFLOAT,
+        .size = {width, height, 1},
+        .mip_level_count = levelCount,
+        .usage = daxa::ImageUsageFlagBits::SHADER_SAMPLED | daxa::ImageUsageFlagBits::SHADER_STORAGE,
+        .name = "hiz pyramid",
+    });
+
+    for (u32 level = 0; level < levelCount; level++) {
+        levelViews.push_back(device.create_image_view({
+            .type = daxa::ImageViewType::REGULAR_2D,
+            .format = daxa::Format::R32_SFLOAT,
+            .image = image,
+            .slice = {.base_mip_level = level, .level_count = 1},
+            .name = "hiz pyramid level",
+        }));
+    }
+
+    initialized = false;
+    valid = false;
+}
+
+void HiZPyramid::destroy() {
+    for (daxa::ImageViewId view : levelViews) {
+        device.destroy_image_view(view);
+    }
+    levelViews.clear();
+    device.destroy_image(image);
+}
+
+void HiZPyramid::resize(u32 _depthWidth, u32 _depthHeight) {
+    destroy();
+    create(_depthWidth, _depthHeight);
+}
+
+void HiZPyramid::build(daxa::CommandList &cmd_list, daxa::ImageViewId depthView) {
+    // the pyramid stays in GENERAL so it can be written level by level and sampled by the cull pass
+    cmd_list.pipeline_barrier_image_transition({
+        .src_access = daxa::AccessConsts::COMPUTE_SHADER_READ,
+        .dst_access = daxa::AccessConsts::COMPUTE_SHADER_WRITE,
+        .src_layout = initialized ? daxa::ImageLayout::GENERAL : daxa::ImageLayout::UNDEFINED,
+        .dst_layout = daxa::ImageLayout::GENERAL,
+        .image_slice = {.base_mip_level = 0, .level_count = levelCount},
+        .image_id = image,
+    });
+    initialized = true;
+
+    cmd_list.set_pipeline(*buildPipeline);
+
+    u32 srcWidth = depthWidth;
+    u32 srcHeight = depthHeight;
+    for (u32 level = 0; level < levelCount; level++) {
+        const u32 dstWidth = std::max(1u, width >> level);
+        const u32 dstHeight = std::max(1u, height >> level);
+
+        cmd_list.push_constant(HiZPush {
+            .src = level == 0 ? depthView : levelViews[level - 1],
+            .dst = levelViews[level],
+            .srcSize = {srcWidth, srcHeight},
+            .dstSize = {dstWidth, dstHeight},
+        });
+        cmd_list.dispatch((dstWidth + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, (dstHeight + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE, 1);
+
+        // the next level reads this one
+        cmd_list.pipeline_barrier({
+            .src_access = daxa::AccessConsts::COMPUTE_SHADER_WRITE,
+            .dst_access = daxa::AccessConsts::COMPUTE_SHADER_READ,
+        });
+
+        srcWidth = dstWidth;
+        srcHeight = dstHeight;
+    }
+
+    valid = true;
+}
@@ -0,0 +1,27 @@
+#include "shared.inl"
+
+DAXA_DECL_PUSH_CONSTANT(HiZPush, push)
+
+layout(local_size_x = 8, local_size_y = 8) in;
+
+// every texel takes the furthest depth of the 2x2 texels below it, when the level below has an odd size
+// its last row and column are folded into the last texel so nothing is left out
+void main() {
+  u32vec2 p = gl_GlobalInvocationID.xy;
+  if (any(greaterThanEqual(p, push.dstSize))) {
+    return;
+  }
+
+  u32vec2 begin = p * 2u;
+  u32vec2 extra = u32vec2(equal(p, push.dstSize - 1u)) * (push.srcSize & 1u);
+  u32vec2 end = min(begin + 1u + extra, push.srcSize - 1u);
+
+  f32 depth = 0.0;
+  for (u32 y = begin.y; y <= end.y; y++) {
+    for (u32 x = begin.x; x <= end.x; x++) {
+      depth = max(depth, texelFetch(daxa_texture2D(push.src), i32vec2(x, y), 0).r);
+    }
+  }
+
+  imageStore(daxa_image2D(push.dst), i32vec2(p), f32vec4(depth));
+}
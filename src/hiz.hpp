@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <daxa/daxa.hpp>
+#include <daxa/utils/pipeline_manager.hpp>
+
+#include "shared.inl"
+
+// max depth pyramid of the last rendered frame, level 0 is half the depth buffer's resolution
+// and every texel holds the furthest depth of the texels below it
+struct HiZPyramid {
+    HiZPyramid(daxa::Device &_device, daxa::PipelineManager &pipelineManager, u32 _depthWidth, u32 _depthHeight);
+    ~HiZPyramid();
+
+    void resize(u32 _depthWidth, u32 _depthHeight);
+    // reduces the depth buffer into the pyramid, the depth buffer has to be readable by compute shaders
+    void build(daxa::CommandList &cmd_list, daxa::ImageViewId depthView);
+
+    daxa::Device &device;
+    std::shared_ptr<daxa::ComputePipeline> buildPipeline;
+    daxa::ImageId image = {};
+    std::vector<daxa::ImageViewId> levelViews = {};
+    u32 depthWidth = 0;
+    u32 depthHeight = 0;
+    u32 width = 0; // of level 0
+    u32 height = 0;
+    u32 levelCount = 0;
+    bool initialized = false; // the image was transitioned to GENERAL
+    bool valid = false;       // holds the depth of the previous frame
+
+  private:
+    void create(u32 _depthWidth, u32 _depthHeight);
+    void destroy();
+};
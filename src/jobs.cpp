@@ -0,0 +1,96 @@
+#include "jobs.hpp"
+
+// index of the queue owned by the current thread, threads outside the pool have none
+static thread_local u32 currentQueue = ~0u;
+
+JobSystem::JobSystem(u32 _threadCount) : threadCount{_threadCount} {
+    for (u32 i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (u32 i = 0; i < threadCount; i++) {
+        threads.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem() {
+    wait();
+    {
+        std::lock_guard lock{sleepMutex};
+        running = false;
+    }
+    wakeUp.notify_all();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+void JobSystem::schedule(std::function<void()> job) {
+    u32 queueIndex = currentQueue != ~0u ? currentQueue : nextQueue.fetch_add(1) % threadCount;
+    unfinishedJobs.fetch_add(1);
+    {
+        std::lock_guard lock{sleepMutex};
+        queuedJobs.fetch_add(1);
+    }
+    {
+        std::lock_guard lock{queues[queueIndex]->mutex};
+        queues[queueIndex]->jobs.push_back(std::move(job));
+    }
+    wakeUp.notify_one();
+}
+
+bool JobSystem::runOne(u32 queueIndex) {
+    std::function<void()> job = {};
+
+    // own work first, newest job is the most likely to still be in cache
+    if (queueIndex < threadCount) {
+        auto &queue = *queues[queueIndex];
+        std::lock_guard lock{queue.mutex};
+        if (!queue.jobs.empty()) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+    }
+
+    // steal the oldest job of another worker
+    for (u32 offset = 1; !job && offset <= threadCount; offset++) {
+        auto &victim = *queues[(queueIndex + offset) % threadCount];
+        std::lock_guard lock{victim.mutex};
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+        }
+    }
+
+    if (!job) {
+        return false;
+    }
+
+    queuedJobs.fetch_sub(1);
+    job();
+
+    if (unfinishedJobs.fetch_sub(1) == 1) {
+        std::lock_guard lock{sleepMutex};
+        allDone.notify_all();
+    }
+    return true;
+}
+
+void JobSystem::workerLoop(u32 queueIndex) {
+    currentQueue = queueIndex;
+    while (true) {
+        if (runOne(queueIndex)) { continue; }
+
+        std::unique_lock lock{sleepMutex};
+        wakeUp.wait(lock, [this] { return queuedJobs.load() != 0 || !running; });
+        if (!running) { return; }
+    }
+}
+
+void JobSystem::wait() {
+    while (unfinishedJobs.load() != 0) {
+        if (runOne(currentQueue != ~0u ? currentQueue : 0)) { continue; }
+
+        std::unique_lock lock{sleepMutex};
+        allDone.wait(lock, [this] { return unfinishedJobs.load() == 0 || queuedJobs.load() != 0; });
+    }
+}
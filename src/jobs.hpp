@@ -0,0 +1,52 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <daxa/types.hpp>
+
+using namespace daxa::types;
+
+// work stealing thread pool, every worker owns a deque and takes from its back,
+// idle workers steal from the front of the other deques
+struct JobSystem {
+    explicit JobSystem(u32 _threadCount = std::max(1u, std::thread::hardware_concurrency()));
+    ~JobSystem();
+
+    JobSystem(const JobSystem &) = delete;
+    JobSystem &operator=(const JobSystem &) = delete;
+
+    // jobs scheduled from a worker go to its own deque, others are spread round robin
+    void schedule(std::function<void()> job);
+
+    // blocks until every scheduled job has finished, the calling thread helps out in the meantime
+    void wait();
+
+    u32 threadCount;
+
+  private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    bool runOne(u32 queueIndex);
+    void workerLoop(u32 queueIndex);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues = {};
+    std::vector<std::thread> threads = {};
+    std::atomic<u32> nextQueue = 0;
+    std::atomic<u32> queuedJobs = 0;
+    std::atomic<u32> unfinishedJobs = 0;
+    std::atomic<bool> running = true;
+    std::mutex sleepMutex = {};
+    std::condition_variable wakeUp = {};
+    std::condition_variable allDone = {};
+};
@@ -1,8 +1,16 @@
+#include <cstring>
+
 #include "app.hpp"
+#include "headless.hpp"
+
+int main(int argc, char **argv) {
+    if (argc > 1 && std::strcmp(argv[1], "--headless") == 0) {
+        runHeadlessBenchmark();
+        return 0;
+    }
 
-int main() {
     App app = {};
     app.update();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#include "mesh_arena.hpp"
+
+MeshArena::MeshArena(daxa::Device &_device, u32 _capacity) : device{_device}, capacity{_capacity} {
+    this->buffer = device.create_buffer({
+        .size = capacity,
+        .allocate_info = daxa::MemoryFlagBits::DEDICATED_MEMORY,
+        .name = "mesh arena",
+    });
+    freeBlocks.insert({0, capacity});
+}
+
+MeshArena::~MeshArena() {
+    device.destroy_buffer(buffer);
+}
+
+MeshAllocation MeshArena::allocate(u32 size) {
+    size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+    for (auto it = freeBlocks.begin(); it != freeBlocks.end(); it++) {
+        auto [offset, blockSize] = *it;
+        if (blockSize < size) { continue; }
+
+        freeBlocks.erase(it);
+        if (blockSize > size) {
+            freeBlocks.insert({offset + size, blockSize - size});
+        }
+
+        usedBytes += size;
+        allocationCount++;
+        return MeshAllocation { .offset = offset, .size = size };
+    }
+
+    throw std::runtime_error("mesh arena is out of memory");
+}
+
+void MeshArena::free(const MeshAllocation &allocation) {
+    if (allocation.size == 0) { return; }
+    retired.push_back({currentFrame, allocation});
+}
+
+void MeshArena::beginFrame(u64 cpuFrame, u64 gpuFrame) {
+    currentFrame = cpuFrame;
+    std::erase_if(retired, [&](const std::pair<u64, MeshAllocation> &entry) {
+        if (entry.first > gpuFrame) { return false; }
+        release(entry.second);
+        return true;
+    });
+}
+
+void MeshArena::release(const MeshAllocation &allocation) {
+    usedBytes -= allocation.size;
+    allocationCount--;
+
+    auto it = freeBlocks.insert({allocation.offset, allocation.size}).first;
+
+    // merge with the following block
+    auto next = std::next(it);
+    if (next != freeBlocks.end() && it->first + it->second == next->first) {
+        it->second += next->second;
+        freeBlocks.erase(next);
+    }
+
+    // merge with the preceding block
+    if (it != freeBlocks.begin()) {
+        auto prev = std::prev(it);
+        if (prev->first + prev->second == it->first) {
+            prev->second += it->second;
+            freeBlocks.erase(it);
+        }
+    }
+}
+
+MeshArenaStats MeshArena::getStats() const {
+    MeshArenaStats stats = {
+        .capacity = capacity,
+        .usedBytes = usedBytes,
+        .freeBlockCount = static_cast<u32>(freeBlocks.size()),
+        .allocationCount = allocationCount,
+    };
+
+    for (const auto &[offset, size] : freeBlocks) {
+        stats.freeBytes += size;
+        stats.largestFreeBlock = std::max<u64>(stats.largestFreeBlock, size);
+    }
+
+    if (stats.freeBytes != 0) {
+        stats.fragmentation = 1.0f - static_cast<f32>(stats.largestFreeBlock) / static_cast<f32>(stats.freeBytes);
+    }
+
+    return stats;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <map>
+#include <vector>
+#include <daxa/daxa.hpp>
+
+using namespace daxa::types;
+
+// range of the mesh arena owned by a single chunk mesh
+struct MeshAllocation {
+    u32 offset = 0; // bytes
+    u32 size = 0;   // bytes
+};
+
+struct MeshArenaStats {
+    u64 capacity = 0;
+    u64 usedBytes = 0;
+    u64 freeBytes = 0;
+    u64 largestFreeBlock = 0;
+    u32 freeBlockCount = 0;
+    u32 allocationCount = 0;
+    f32 fragmentation = 0.0f; // 0 when all free memory is one block, close to 1 when it is scattered
+};
+
+// one device-local buffer shared by all chunk meshes, ranges are handed out through a first-fit free list
+struct MeshArena {
+    static constexpr u32 ALIGNMENT = 64;
+
+    MeshArena(daxa::Device &_device, u32 _capacity);
+    ~MeshArena();
+
+    MeshAllocation allocate(u32 size);
+    // frames in flight may still draw from a freed range, so it only becomes reusable once the GPU finished them
+    void free(const MeshAllocation &allocation);
+
+    // cpuFrame is the last frame recorded so far, gpuFrame the last one the GPU finished
+    void beginFrame(u64 cpuFrame, u64 gpuFrame);
+
+    MeshArenaStats getStats() const;
+
+    daxa::BufferId buffer;
+    daxa::Device &device;
+    u32 capacity;
+    u32 usedBytes = 0;
+    u32 allocationCount = 0;
+    std::map<u32, u32> freeBlocks = {}; // offset -> size, ordered by offset so neighbours can be merged
+    u64 currentFrame = 0;
+    std::vector<std::pair<u64, MeshAllocation>> retired = {}; // frame that last could use it -> range
+
+  private:
+    void release(const MeshAllocation &allocation);
+};
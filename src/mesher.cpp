@@ -0,0 +1,268 @@
+#include <chrono>
+
+#include "mesher.hpp"
+
+// in-plane axes of a face, chosen so that side faces have v pointing up (+y)
+static constexpr std::array<std::array<i32, 2>, 3> FACE_PLANE_AXES = {{
+    {2, 1}, // x faces: u = z, v = y
+    {0, 2}, // y faces: u = x, v = z
+    {0, 1}, // z faces: u = x, v = y
+}};
+
+// corner is in block corner space (0..CHUNK_SIZE), block centers sit at +0.5
+static Vertex makeVertex(const glm::ivec3 &corner, [[maybe_unused]] u32 face, i32 u, i32 v, u32 layer) {
+#if PACKED_VERTICES
+    return Vertex {
+        .data0 = static_cast<u32>(corner.x) | static_cast<u32>(corner.y) << 5 | static_cast<u32>(corner.z) << 10 | face << 15,
+        .data1 = static_cast<u32>(u) | static_cast<u32>(v) << 5 | layer << 10,
+    };
+#else
+    return Vertex {
+        { static_cast<f32>(corner.x) - 0.5f, static_cast<f32>(corner.y) - 0.5f, static_cast<f32>(corner.z) - 0.5f },
+        { 1.0f, 1.0f, 1.0f },
+        layer,
+        { static_cast<f32>(u), static_cast<f32>(v) },
+    };
+#endif
+}
+
+void ChunkMesh::addQuad(u32 face, const glm::ivec3 &origin, i32 width, i32 height, u32 layer) {
+    quadCount++;
+    faceQuadCounts[face]++;
+
+    if (backend == MeshBackend::Faces) {
+        // packed in cells, the vertex shader scales them back up by the descriptor's lod
+        const glm::ivec3 cell = origin / (1 << lod);
+        const u32 cellWidth = static_cast<u32>(width) >> lod;
+        const u32 cellHeight = static_cast<u32>(height) >> lod;
+        faces.push_back(Face {
+            .data = static_cast<u32>(cell.x) | static_cast<u32>(cell.y) << 4 | static_cast<u32>(cell.z) << 8 | face << 12 |
+                    (cellWidth - 1) << 15 | (cellHeight - 1) << 19 | layer << 23,
+        });
+        return;
+    }
+
+    const i32 cellSize = 1 << lod;
+
+    const i32 axis = static_cast<i32>(face / 2);
+    const i32 uAxis = FACE_PLANE_AXES[axis][0];
+    const i32 vAxis = FACE_PLANE_AXES[axis][1];
+
+    auto corner = [&](i32 du, i32 dv) {
+        glm::ivec3 p = origin;
+        p[axis] += static_cast<i32>(face % 2) * cellSize;
+        p[uAxis] += du;
+        p[vAxis] += dv;
+        return makeVertex(p, face, du, dv, layer);
+    };
+
+    // u x v points along -x for x faces and -y for y faces, keep the winding counter-clockwise seen from outside
+    const bool uvAlongNormal = (axis == 2) == (face % 2 == 1);
+    if (uvAlongNormal) {
+        vertices.insert(vertices.end(), {corner(0, 0), corner(width, 0), corner(width, height), corner(0, height)});
+    } else {
+        vertices.insert(vertices.end(), {corner(0, 0), corner(0, height), corner(width, height), corner(width, 0)});
+    }
+}
+
+u32 ChunkMesh::byteSize() const {
+    if (backend == MeshBackend::Faces) {
+        return static_cast<u32>(faces.size() * sizeof(Face));
+    }
+    return static_cast<u32>(vertices.size() * sizeof(Vertex));
+}
+
+const void *ChunkMesh::data() const {
+    if (backend == MeshBackend::Faces) {
+        return faces.data();
+    }
+    return vertices.data();
+}
+
+static void meshNaive(const PaddedVoxels &voxels, ChunkMesh &mesh) {
+    for (u32 face = 0; face < 6; face++) {
+        for (i32 z = 0; z < CHUNK_SIZE; z++) {
+            for (i32 y = 0; y < CHUNK_SIZE; y++) {
+                for (i32 x = 0; x < CHUNK_SIZE; x++) {
+                    glm::ivec3 voxel_pos = { x, y, z };
+                    BlockID id = voxels.getVoxel(voxel_pos);
+                    if (id == BlockID::Air) { continue; }
+
+                    if (voxels.getVoxel(voxel_pos + FACE_NORMALS[face]) == BlockID::Air) {
+                        mesh.addQuad(face, voxel_pos, 1, 1, faceLayer(id, face));
+                    }
+                }
+            }
+        }
+    }
+}
+
+// meshes a size^3 grid of cells that are cellSize blocks wide, getVoxel reads cells from -1 to size on every axis
+template <typename GetVoxel>
+static void meshGreedy(i32 size, i32 cellSize, const GetVoxel &getVoxel, ChunkMesh &mesh) {
+    std::array<BlockID, CHUNK_SIZE * CHUNK_SIZE> mask = {};
+
+    for (u32 face = 0; face < 6; face++) {
+        const i32 axis = static_cast<i32>(face / 2);
+        const i32 uAxis = FACE_PLANE_AXES[axis][0];
+        const i32 vAxis = FACE_PLANE_AXES[axis][1];
+        const glm::ivec3 normal = FACE_NORMALS[face];
+
+        for (i32 slice = 0; slice < size; slice++) {
+            // mask of faces in this slice that are visible from the normal direction
+            for (i32 v = 0; v < size; v++) {
+                for (i32 u = 0; u < size; u++) {
+                    glm::ivec3 p = {};
+                    p[axis] = slice;
+                    p[uAxis] = u;
+                    p[vAxis] = v;
+                    BlockID id = getVoxel(p);
+                    bool visible = id != BlockID::Air && getVoxel(p + normal) == BlockID::Air;
+                    mask[v * size + u] = visible ? id : BlockID::Air;
+                }
+            }
+
+            // grow each unvisited face along u, then along v while the whole row matches
+            for (i32 v = 0; v < size; v++) {
+                for (i32 u = 0; u < size;) {
+                    BlockID id = mask[v * size + u];
+                    if (id == BlockID::Air) {
+                        u++;
+                        continue;
+                    }
+
+                    i32 width = 1;
+                    while (u + width < size && mask[v * size + u + width] == id) {
+                        width++;
+                    }
+
+                    i32 height = 1;
+                    for (; v + height < size; height++) {
+                        bool rowMatches = true;
+                        for (i32 k = 0; k < width; k++) {
+                            if (mask[(v + height) * size + u + k] != id) {
+                                rowMatches = false;
+                                break;
+                            }
+                        }
+                        if (!rowMatches) { break; }
+                    }
+
+                    glm::ivec3 origin = {};
+                    origin[axis] = slice;
+                    origin[uAxis] = u;
+                    origin[vAxis] = v;
+                    mesh.addQuad(face, origin * cellSize, width * cellSize, height * cellSize, faceLayer(id, face));
+
+                    for (i32 dv = 0; dv < height; dv++) {
+                        for (i32 du = 0; du < width; du++) {
+                            mask[(v + dv) * size + u + du] = BlockID::Air;
+                        }
+                    }
+                    u += width;
+                }
+            }
+        }
+    }
+}
+
+// cells of the largest lod grid, lod 1
+using LodCells = std::array<BlockID, CHUNK_VOLUME / 8>;
+
+// a cell is solid when at least half of its blocks are, and takes the most common BlockID of its topmost layer
+// that has any solid blocks. the grass on top of the dirt is usually a thin layer in the bottom of a cell that
+// ends up air, so a solid cell below such a cell takes its top block instead and the grass stays visible in the distance
+static void downsample(const PaddedVoxels &voxels, i32 cellSize, LodCells &cells) {
+    const i32 size = CHUNK_SIZE / cellSize;
+    cells.fill(BlockID::Air);
+    LodCells tops;
+
+    for (i32 z = 0; z < size; z++) {
+        for (i32 y = 0; y < size; y++) {
+            for (i32 x = 0; x < size; x++) {
+                i32 airCount = 0;
+                BlockID top = BlockID::Air;
+                for (i32 dy = cellSize - 1; dy >= 0; dy--) {
+                    std::array<i32, 4> counts = {};
+                    for (i32 dz = 0; dz < cellSize; dz++) {
+                        for (i32 dx = 0; dx < cellSize; dx++) {
+                            counts[static_cast<usize>(voxels.getVoxel(glm::ivec3{x, y, z} * cellSize + glm::ivec3{dx, dy, dz}))]++;
+                        }
+                    }
+                    airCount += counts[static_cast<usize>(BlockID::Air)];
+                    if (top != BlockID::Air) { continue; }
+
+                    usize mostCommon = static_cast<usize>(BlockID::Grass);
+                    for (usize id = mostCommon + 1; id < counts.size(); id++) {
+                        if (counts[id] > counts[mostCommon]) { mostCommon = id; }
+                    }
+                    if (counts[mostCommon] != 0) { top = static_cast<BlockID>(mostCommon); }
+                }
+
+                tops[voxelIndex({x, y, z}, size)] = top;
+                if (airCount * 2 <= cellSize * cellSize * cellSize) {
+                    cells[voxelIndex({x, y, z}, size)] = top;
+                }
+            }
+        }
+    }
+
+    for (i32 z = 0; z < size; z++) {
+        for (i32 y = 0; y + 1 < size; y++) {
+            for (i32 x = 0; x < size; x++) {
+                const usize above = voxelIndex({x, y + 1, z}, size);
+                if (cells[voxelIndex({x, y, z}, size)] != BlockID::Air && cells[above] == BlockID::Air && tops[above] != BlockID::Air) {
+                    cells[voxelIndex({x, y, z}, size)] = tops[above];
+                }
+            }
+        }
+    }
+}
+
+void ChunkMesh::reserveWorstCase() {
+    vertices.reserve(static_cast<usize>(MAX_CHUNK_QUADS) * 4);
+    faces.reserve(MAX_CHUNK_QUADS);
+}
+
+void meshChunk(const PaddedVoxels &voxels, MesherType mesher, MeshBackend backend, u32 lod, ChunkMesh &mesh) {
+    mesh.backend = backend;
+    mesh.lod = lod;
+    mesh.vertices.clear();
+    mesh.faces.clear();
+    mesh.quadCount = 0;
+    mesh.faceQuadCounts = {};
+
+    mesh.meshTime = 0.0;
+    // most chunks above the surface are all air, there is nothing to scan
+    if (voxels.emptyCenter) { return; }
+
+    auto meshStart = std::chrono::steady_clock::now();
+    if (lod != 0) {
+        const i32 cellSize = 1 << lod;
+        const i32 size = CHUNK_SIZE / cellSize;
+        LodCells cells;
+        downsample(voxels, cellSize, cells);
+        meshGreedy(size, cellSize, [&](const glm::ivec3 &p) {
+            if (p.x < 0 || p.y < 0 || p.z < 0 || p.x >= size || p.y >= size || p.z >= size) {
+                return BlockID::Air;
+            }
+            return cells[voxelIndex(p, size)];
+        }, mesh);
+    } else if (mesher == MesherType::Greedy) {
+        meshGreedy(CHUNK_SIZE, 1, [&](const glm::ivec3 &p) { return voxels.getVoxel(p); }, mesh);
+    } else {
+        meshNaive(voxels, mesh);
+    }
+    mesh.meshTime = std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - meshStart).count();
+}
+
+ChunkMesh meshChunk(const PaddedVoxels &voxels, MesherType mesher, MeshBackend backend, u32 lod) {
+    // every worker meshes into its own worst case sized buffer and the result is copied out at its exact size
+    thread_local ChunkMesh scratch = [] {
+        ChunkMesh mesh = {};
+        mesh.reserveWorstCase();
+        return mesh;
+    }();
+    meshChunk(voxels, mesher, backend, lod, scratch);
+    return scratch;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "shared.inl"
+#include "voxels.hpp"
+
+// every chunk quad is 4 vertices, drawn with 6 indices from the shared quad index buffer
+static constexpr u32 MAX_CHUNK_QUADS = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 6;
+
+// lod 1, 2 and 3 mesh the chunk downsampled to cells of 2, 4 and 8 blocks
+static constexpr u32 MAX_LOD = 3;
+
+// naive emits every exposed face on its own, greedy merges coplanar faces with the same BlockID into quads
+enum struct MesherType {
+    Naive,
+    Greedy
+};
+
+// vertices stores 4 Vertex per quad drawn through the quad index buffer,
+// faces stores one packed Face per quad that the vertex shader expands into 6 vertices
+enum struct MeshBackend {
+    Vertices,
+    Faces
+};
+
+struct ChunkMesh {
+    MeshBackend backend = MeshBackend::Vertices;
+    u32 lod = 0;
+    std::vector<Vertex> vertices = {};
+    std::vector<Face> faces = {};
+    u32 quadCount = 0;
+    // quads are stored in one bucket per face direction so buckets facing away from the camera can be skipped
+    std::array<u32, 6> faceQuadCounts = {};
+    f64 meshTime = 0.0; // milliseconds
+
+    // faces are ordered -x, +x, -y, +y, -z, +z, origin is the block with the smallest coordinates covered by the quad,
+    // quads have to be added face by face in that order, in lod meshes origin and size are multiples of the cell size
+    // layer is the quad's texture array layer
+    void addQuad(u32 face, const glm::ivec3 &origin, i32 width, i32 height, u32 layer);
+
+    // makes room for the most quads a chunk can have so meshing into this mesh never allocates
+    void reserveWorstCase();
+
+    u32 byteSize() const;
+    const void *data() const;
+};
+
+// builds the mesh of a chunk on the CPU, faces against solid blocks of the neighbours in the border are culled,
+// safe to call from any thread
+// lod meshes are always greedy and ignore the border: their faces on the chunk's sides are kept as skirts
+// that cover the cracks against neighbours meshed at another lod
+ChunkMesh meshChunk(const PaddedVoxels &voxels, MesherType mesher, MeshBackend backend, u32 lod = 0);
+// same as above but replaces the contents of mesh, it only allocates when mesh runs out of capacity,
+// which a mesh prepared with reserveWorstCase never does
+void meshChunk(const PaddedVoxels &voxels, MesherType mesher, MeshBackend backend, u32 lod, ChunkMesh &mesh);
@@ -0,0 +1,185 @@
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "region.hpp"
+
+static constexpr u32 REGION_MAGIC = 0x4e474552; // "REGN"
+static constexpr u32 REGION_VERSION = 2;
+static constexpr u32 TABLE_OFFSET = 2 * sizeof(u32) + sizeof(u64);
+static constexpr u32 HEADER_SIZE = TABLE_OFFSET + REGION_SIZE * REGION_SIZE * 2 * sizeof(u32);
+// flying around opens new regions forever, past this many every open file is closed
+static constexpr usize MAX_OPEN_REGIONS = 64;
+
+static i32 floorDiv(i32 a, i32 b) {
+    return a >= 0 ? a / b : -((-a - 1) / b) - 1;
+}
+
+static glm::ivec3 regionOf(const glm::ivec3 &chunkPos) {
+    return {floorDiv(chunkPos.x, REGION_SIZE), chunkPos.y, floorDiv(chunkPos.z, REGION_SIZE)};
+}
+
+// position in the offset table, rows of x
+static usize indexInRegion(const glm::ivec3 &chunkPos, const glm::ivec3 &regionPos) {
+    return static_cast<usize>((chunkPos.z - regionPos.z * REGION_SIZE) * REGION_SIZE + chunkPos.x - regionPos.x * REGION_SIZE);
+}
+
+template <typename T>
+static void append(std::vector<u8> &data, const T &value) {
+    const usize offset = data.size();
+    data.resize(offset + sizeof(T));
+    std::memcpy(data.data() + offset, &value, sizeof(T));
+}
+
+template <typename T>
+static bool take(const std::vector<u8> &data, usize &offset, T &value) {
+    if (offset + sizeof(T) > data.size()) { return false; }
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+
+RegionStorage::RegionStorage(const std::filesystem::path &_directory, u64 _generatorKey) : directory{_directory}, generatorKey{_generatorKey} {
+    std::filesystem::create_directories(directory);
+}
+
+// layout: u8 bitsPerIndex, u16 palette size, the palette, then (u16 repeat count, u64 word) runs covering every word
+std::vector<u8> RegionStorage::encodeChunk(const ChunkVoxels &voxels) {
+    std::vector<u8> data = {};
+    append(data, static_cast<u8>(voxels.bitsPerIndex));
+    append(data, static_cast<u16>(voxels.palette.size()));
+    for (BlockID id : voxels.palette) {
+        append(data, id);
+    }
+
+    for (usize i = 0; i < voxels.words.size();) {
+        u16 count = 1;
+        while (i + count < voxels.words.size() && voxels.words[i + count] == voxels.words[i] && count < UINT16_MAX) {
+            count++;
+        }
+        append(data, count);
+        append(data, voxels.words[i]);
+        i += count;
+    }
+    return data;
+}
+
+bool RegionStorage::decodeChunk(const std::vector<u8> &data, ChunkVoxels &voxels) {
+    usize offset = 0;
+    u8 bits = 0;
+    u16 paletteSize = 0;
+    if (!take(data, offset, bits) || !take(data, offset, paletteSize)) { return false; }
+    if (bits > 16 || (bits & (bits - 1)) != 0 || paletteSize == 0 || paletteSize > (1u << bits)) { return false; }
+
+    voxels.palette.resize(paletteSize);
+    for (BlockID &id : voxels.palette) {
+        if (!take(data, offset, id)) { return false; }
+    }
+
+    const usize wordCount = static_cast<usize>(CHUNK_VOLUME) * bits / 64;
+    voxels.words.clear();
+    voxels.words.reserve(wordCount);
+    while (voxels.words.size() < wordCount) {
+        u16 count = 0;
+        u64 word = 0;
+        if (!take(data, offset, count) || !take(data, offset, word)) { return false; }
+        if (count == 0 || voxels.words.size() + count > wordCount) { return false; }
+        voxels.words.insert(voxels.words.end(), count, word);
+    }
+    voxels.bitsPerIndex = bits;
+
+    // indices past the end of a damaged palette read as air instead of out of bounds
+    voxels.palette.resize(usize{1} << bits, BlockID::Air);
+    voxels.compact();
+    return offset == data.size();
+}
+
+RegionStorage::RegionFile &RegionStorage::openRegion(const glm::ivec3 &regionPos) {
+    auto it = regions.find(regionPos);
+    if (it != regions.end()) { return *it->second; }
+    if (regions.size() >= MAX_OPEN_REGIONS) {
+        regions.clear();
+    }
+
+    const std::filesystem::path path = directory / ("r." + std::to_string(regionPos.x) + "." + std::to_string(regionPos.y) + "." +
+                                                    std::to_string(regionPos.z) + ".region");
+    auto region = std::make_unique<RegionFile>();
+
+    bool valid = false;
+    if (std::filesystem::exists(path)) {
+        region->file.open(path, std::ios::in | std::ios::out | std::ios::binary);
+        u32 magic = 0;
+        u32 version = 0;
+        u64 key = 0;
+        region->file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+        region->file.read(reinterpret_cast<char *>(&version), sizeof(version));
+        region->file.read(reinterpret_cast<char *>(&key), sizeof(key));
+        region->file.read(reinterpret_cast<char *>(region->table.data()), sizeof(region->table));
+        valid = region->file.good() && magic == REGION_MAGIC && version == REGION_VERSION && key == generatorKey;
+        region->file.seekg(0, std::ios::end);
+        region->end = static_cast<u32>(region->file.tellg());
+    }
+
+    // missing or unreadable files and ones from another world are started over
+    if (!valid) {
+        region->file.close();
+        region->file.open(path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!region->file.is_open()) {
+            throw std::runtime_error("failed to open region file " + path.string());
+        }
+        region->table = {};
+        region->file.write(reinterpret_cast<const char *>(&REGION_MAGIC), sizeof(REGION_MAGIC));
+        region->file.write(reinterpret_cast<const char *>(&REGION_VERSION), sizeof(REGION_VERSION));
+        region->file.write(reinterpret_cast<const char *>(&generatorKey), sizeof(generatorKey));
+        region->file.write(reinterpret_cast<const char *>(region->table.data()), sizeof(region->table));
+        region->end = HEADER_SIZE;
+    }
+    region->file.clear();
+
+    return *regions.emplace(regionPos, std::move(region)).first->second;
+}
+
+bool RegionStorage::load(const glm::ivec3 &chunkPos, ChunkVoxels &voxels) {
+    const glm::ivec3 regionPos = regionOf(chunkPos);
+    const usize index = indexInRegion(chunkPos, regionPos);
+
+    std::vector<u8> data = {};
+    {
+        std::lock_guard lock{mutex};
+        RegionFile &region = openRegion(regionPos);
+        const TableEntry entry = region.table[index];
+        if (entry.offset == 0) { return false; }
+
+        data.resize(entry.size);
+        region.file.seekg(entry.offset);
+        region.file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!region.file.good()) {
+            region.file.clear();
+            return false;
+        }
+    }
+    return decodeChunk(data, voxels);
+}
+
+void RegionStorage::save(const glm::ivec3 &chunkPos, const ChunkVoxels &voxels) {
+    const glm::ivec3 regionPos = regionOf(chunkPos);
+    const usize index = indexInRegion(chunkPos, regionPos);
+    const std::vector<u8> data = encodeChunk(voxels);
+
+    std::lock_guard lock{mutex};
+    RegionFile &region = openRegion(regionPos);
+    TableEntry &entry = region.table[index];
+
+    // a chunk that shrank is rewritten in place, otherwise it moves to the end and its old bytes are left unused
+    if (entry.offset == 0 || entry.size < data.size()) {
+        entry.offset = region.end;
+        region.end += static_cast<u32>(data.size());
+    }
+    entry.size = static_cast<u32>(data.size());
+
+    region.file.seekp(entry.offset);
+    region.file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    region.file.seekp(static_cast<std::streamoff>(TABLE_OFFSET + index * sizeof(TableEntry)));
+    region.file.write(reinterpret_cast<const char *>(&entry), sizeof(TableEntry));
+    region.file.flush();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <daxa/types.hpp>
+#include <glm/glm.hpp>
+
+#include "voxels.hpp"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include "glm/gtx/hash.hpp"
+
+using namespace daxa::types;
+
+// a region file holds REGION_SIZE x REGION_SIZE chunk columns of a single chunk layer
+static constexpr i32 REGION_SIZE = 32;
+
+// chunk voxels saved to disk, grouped into region files named r.<x>.<y>.<z>.region inside directory,
+// every file starts with the generator key and an offset table and the compressed chunks follow it in any order.
+// files saved under another key are started over when they are opened
+struct RegionStorage {
+    RegionStorage(const std::filesystem::path &_directory, u64 _generatorKey);
+
+    RegionStorage(const RegionStorage &) = delete;
+    RegionStorage &operator=(const RegionStorage &) = delete;
+
+    // thread safe, returns false when the chunk was never saved or its data can't be read back
+    bool load(const glm::ivec3 &chunkPos, ChunkVoxels &voxels);
+    // thread safe, replaces a previously saved version of the chunk
+    void save(const glm::ivec3 &chunkPos, const ChunkVoxels &voxels);
+
+    // chunk blobs in the region files, they are the palette and packed indices of ChunkVoxels with repeated words run length encoded
+    static std::vector<u8> encodeChunk(const ChunkVoxels &voxels);
+    static bool decodeChunk(const std::vector<u8> &data, ChunkVoxels &voxels);
+
+  private:
+    struct TableEntry {
+        u32 offset = 0; // bytes from the start of the file, 0 when the chunk isn't saved
+        u32 size = 0;   // bytes
+    };
+
+    struct RegionFile {
+        std::fstream file;
+        std::array<TableEntry, REGION_SIZE * REGION_SIZE> table = {};
+        u32 end = 0; // where the next appended chunk goes
+    };
+
+    // opens or creates the region file, the mutex has to be held
+    RegionFile &openRegion(const glm::ivec3 &regionPos);
+
+    std::filesystem::path directory;
+    u64 generatorKey; // WorldGenerator::key
+    std::mutex mutex = {};
+    std::unordered_map<glm::ivec3, std::unique_ptr<RegionFile>> regions = {};
+};
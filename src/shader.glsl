@@ -6,23 +6,73 @@ DAXA_DECL_PUSH_CONSTANT(DrawPush, push)
 
 layout(location = 0) out f32vec3 out_color;
 layout(location = 1) out f32vec2 out_uv;
+layout(location = 2) flat out u32 out_layer;
+
+#if FACE_PULLING
+// corners of the two triangles of a quad, 0 = (0, 0), 1 = (w, 0), 2 = (w, h), 3 = (0, h)
+const u32 QUAD_CORNERS[6] = u32[6](0, 1, 2, 2, 3, 0);
+// in-plane axes of x, y and z faces, matching FACE_PLANE_AXES in mesher.cpp
+const i32 FACE_U_AXIS[3] = i32[3](2, 0, 0);
+const i32 FACE_V_AXIS[3] = i32[3](1, 2, 1);
+#endif
 
 void main() {
-  out_color = deref(push.vertices[gl_VertexIndex]).color;
-  gl_Position = push.modelViewProjection * vec4(deref(push.vertices[gl_VertexIndex]).pos, 1.0);
-  out_uv = deref(push.vertices[gl_VertexIndex]).uv;
+  // the draw's first instance is the chunk's descriptor slot
+  ChunkDescriptor chunk = deref(push.chunks[gl_InstanceIndex]);
+  f32vec3 chunkOrigin = f32vec3(chunk.position * 16);
+
+#if FACE_PULLING
+  u32 data = deref(chunk.faces[gl_VertexIndex / 6]).data;
+  // lod meshes store cells, scale them back to blocks
+  i32 cellSize = 1 << chunk.lod;
+  i32vec3 p = i32vec3(data & 15u, (data >> 4) & 15u, (data >> 8) & 15u) * cellSize;
+  u32 face = (data >> 12) & 7u;
+  i32 width = (i32((data >> 15) & 15u) + 1) * cellSize;
+  i32 height = (i32((data >> 19) & 15u) + 1) * cellSize;
+  i32 axis = i32(face / 2u);
+
+  u32 corner = QUAD_CORNERS[gl_VertexIndex % 6];
+  // walk the corners the other way round when u x v points against the face normal
+  if ((axis == 2) != (face % 2u == 1u)) {
+    corner = (4u - corner) % 4u;
+  }
+  i32 du = (corner == 1u || corner == 2u) ? width : 0;
+  i32 dv = (corner == 2u || corner == 3u) ? height : 0;
+
+  p[axis] += i32(face % 2u) * cellSize;
+  p[FACE_U_AXIS[axis]] += du;
+  p[FACE_V_AXIS[axis]] += dv;
+
+  out_color = f32vec3(1.0);
+  gl_Position = push.viewProjection * vec4(chunkOrigin + f32vec3(p) - 0.5, 1.0);
+  out_uv = f32vec2(du, dv);
+  out_layer = (data >> 23) & 255u;
+#elif PACKED_VERTICES
+  Vertex vertex = deref(chunk.vertices[gl_VertexIndex]);
+  f32vec3 pos = f32vec3(vertex.data0 & 31u, (vertex.data0 >> 5) & 31u, (vertex.data0 >> 10) & 31u) - 0.5;
+  out_color = f32vec3(1.0);
+  gl_Position = push.viewProjection * vec4(chunkOrigin + pos, 1.0);
+  out_uv = f32vec2(vertex.data1 & 31u, (vertex.data1 >> 5) & 31u);
+  out_layer = vertex.data1 >> 10;
+#else
+  out_color = deref(chunk.vertices[gl_VertexIndex]).color;
+  gl_Position = push.viewProjection * vec4(chunkOrigin + deref(chunk.vertices[gl_VertexIndex]).pos, 1.0);
+  out_uv = deref(chunk.vertices[gl_VertexIndex]).uv;
+  out_layer = deref(chunk.vertices[gl_VertexIndex]).id;
+#endif
 }
 
 #elif DAXA_SHADER_STAGE == DAXA_SHADER_STAGE_FRAGMENT
 
 layout(location = 0) in f32vec3 in_color;
 layout(location = 1) in f32vec2 in_uv;
+layout(location = 2) flat in u32 in_layer;
 
 layout(location = 0) out vec4 color;
 
 void main() {
     //color = vec4(in_color, 1.0);
-    color = vec4(texture(daxa_sampler2DArray(push.textures, push.texturesSampler), vec3(in_uv, 1.0)).rgb, 1.0);
+    color = vec4(texture(daxa_sampler2DArray(push.textures, push.texturesSampler), vec3(in_uv, f32(in_layer))).rgb, 1.0);
 }
 
 #endif
\ No newline at end of file
@@ -2,19 +2,117 @@
 #define DAXA_ENABLE_SHADER_NO_NAMESPACE 1
 #include <daxa/daxa.inl>
 
+// 1 packs every vertex into 8 bytes, 0 keeps the full float layout
+#define PACKED_VERTICES 1
+
+#if PACKED_VERTICES
+// data0: x 5 bits | y 5 bits | z 5 bits | face 3 bits, positions are block corners in 0..16
+// data1: u 5 bits | v 5 bits | texture layer 8 bits
+struct Vertex {
+    daxa_u32 data0;
+    daxa_u32 data1;
+};
+#else
 struct Vertex {
     daxa_f32vec3 pos;
     daxa_f32vec3 color;
-    daxa_u32 id;
+    daxa_u32 id; // texture layer
     daxa_f32vec2 uv;
 };
+#endif
 
 DAXA_DECL_BUFFER_PTR(Vertex)
 
-struct DrawPush {
-    daxa_f32mat4x4 modelViewProjection;
+// one quad of the face pulling backend, expanded into 6 vertices in the vertex shader
+// data: x 4 bits | y 4 bits | z 4 bits | face 3 bits | width - 1 4 bits | height - 1 4 bits | texture layer 8 bits
+struct Face {
+    daxa_u32 data;
+};
+
+DAXA_DECL_BUFFER_PTR(Face)
+
+// one slot of the chunk descriptor buffer, the draws of a frame use the slot index as their first instance
+// so the vertex shader can find the chunk through gl_InstanceIndex
+#define MAX_CHUNK_SLOTS 32768
+#define CHUNK_BACKEND_VERTICES 0u
+#define CHUNK_BACKEND_FACES 1u
+
+struct ChunkDescriptor {
+    daxa_i32vec3 position; // in chunks
+    daxa_u32 quadCount;    // 0 for empty chunks and unused slots
     daxa_BufferPtr(Vertex) vertices;
+    daxa_BufferPtr(Face) faces; // same address as vertices, the backend decides which one is read
+    daxa_u32 backend;
+    // quads per face direction, stored one direction after another in the order -x, +x, -y, +y, -z, +z
+    daxa_u32 faceQuadCounts[6];
+    daxa_u32 lod; // packed faces are in cells of 1 << lod blocks
+};
+
+DAXA_DECL_BUFFER_PTR(ChunkDescriptor)
+
+// same layouts as VkDrawIndirectCommand and VkDrawIndexedIndirectCommand
+struct DrawCommand {
+    daxa_u32 vertexCount;
+    daxa_u32 instanceCount;
+    daxa_u32 firstVertex;
+    daxa_u32 firstInstance;
+};
+
+struct DrawIndexedCommand {
+    daxa_u32 indexCount;
+    daxa_u32 instanceCount;
+    daxa_u32 firstIndex;
+    daxa_i32 vertexOffset;
+    daxa_u32 firstInstance;
+};
+
+// every chunk draws up to one bucket per face direction
+#define MAX_CHUNK_DRAWS (MAX_CHUNK_SLOTS * 6)
+
+// written by the cull shader every frame, the draw counts are read by draw_indirect_count
+struct CullOutput {
+    daxa_u32 vertexDrawCount;
+    daxa_u32 faceDrawCount;
+    daxa_u32 culledCount;   // outside the frustum
+    daxa_u32 occludedCount; // inside the frustum but behind the previous frame's depth
+    DrawIndexedCommand vertexDraws[MAX_CHUNK_DRAWS];
+    DrawCommand faceDraws[MAX_CHUNK_DRAWS];
+};
+
+DAXA_DECL_BUFFER_PTR(CullOutput)
+
+// too large for push constants, written by the CPU into a small ring indexed by frame
+struct CullParams {
+    daxa_f32vec4 frustumPlanes[6];
+    daxa_f32vec3 cameraPosition; // in world space, picks the face buckets that can face the camera
+    // the previous frame's view projection and depth pyramid, occlusion is skipped while occlusion is 0
+    daxa_f32mat4x4 occlusionViewProjection;
+    daxa_ImageViewId hiz;
+    daxa_u32vec2 hizSize; // of level 0
+    daxa_u32 hizLevelCount;
+    daxa_u32 occlusion;
+};
+
+DAXA_DECL_BUFFER_PTR(CullParams)
+
+struct CullPush {
+    daxa_BufferPtr(CullParams) params;
+    daxa_BufferPtr(ChunkDescriptor) chunks;
+    daxa_RWBufferPtr(CullOutput) draws;
+    daxa_u32 slotCount;
+};
+
+// one level of the depth pyramid, src is the depth buffer for level 0 and the level above otherwise
+struct HiZPush {
+    daxa_ImageViewId src;
+    daxa_ImageViewId dst;
+    daxa_u32vec2 srcSize;
+    daxa_u32vec2 dstSize;
+};
+
+struct DrawPush {
+    daxa_f32mat4x4 viewProjection;
+    daxa_BufferPtr(ChunkDescriptor) chunks;
     daxa_ImageViewId textures;
     daxa_SamplerId texturesSampler;
 };
-
@@ -0,0 +1,91 @@
+#include "streaming.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+ChunkStreamer::ChunkStreamer(const StreamingSettings &_settings) : settings{_settings} {
+    for (i32 x = -settings.loadRadius; x <= settings.loadRadius; x++) {
+        for (i32 y = settings.meshedLayers.x - 1; y <= settings.meshedLayers.y + 1; y++) {
+            for (i32 z = -settings.loadRadius; z <= settings.loadRadius; z++) {
+                if (x * x + z * z <= settings.loadRadius * settings.loadRadius) {
+                    loadOffsets.push_back({x, y, z});
+                }
+            }
+        }
+    }
+}
+
+glm::ivec3 ChunkStreamer::chunkAt(const glm::vec3 &worldPos) {
+    return glm::ivec3{glm::floor(worldPos / static_cast<f32>(CHUNK_SIZE))};
+}
+
+bool ChunkStreamer::update(const glm::vec3 &worldPos, const glm::vec3 &_viewDir) {
+    viewDir = _viewDir;
+
+    glm::ivec3 chunkPos = chunkAt(worldPos);
+    if (chunkPos == centerChunk) { return false; }
+
+    centerChunk = chunkPos;
+    complete = false;
+    return true;
+}
+
+bool ChunkStreamer::shouldLoad(const glm::ivec3 &chunkPos) const {
+    glm::ivec3 offset = chunkPos - centerChunk;
+    return offset.x * offset.x + offset.z * offset.z <= settings.loadRadius * settings.loadRadius &&
+           chunkPos.y >= settings.meshedLayers.x - 1 && chunkPos.y <= settings.meshedLayers.y + 1;
+}
+
+bool ChunkStreamer::shouldKeep(const glm::ivec3 &chunkPos) const {
+    glm::ivec3 offset = chunkPos - centerChunk;
+    return offset.x * offset.x + offset.z * offset.z <= settings.unloadRadius * settings.unloadRadius &&
+           chunkPos.y >= settings.meshedLayers.x - 1 && chunkPos.y <= settings.meshedLayers.y + 1;
+}
+
+bool ChunkStreamer::shouldMesh(const glm::ivec3 &chunkPos) const {
+    return chunkPos.y >= settings.meshedLayers.x && chunkPos.y <= settings.meshedLayers.y;
+}
+
+u32 ChunkStreamer::lodFor(const glm::ivec3 &chunkPos) const {
+    glm::ivec3 offset = chunkPos - centerChunk;
+    i32 distanceSquared = offset.x * offset.x + offset.y * offset.y + offset.z * offset.z;
+    u32 lod = 0;
+    for (i32 distance : settings.lodDistances) {
+        if (distanceSquared > distance * distance) { lod++; }
+    }
+    return lod;
+}
+
+std::vector<glm::ivec3> ChunkStreamer::nextRequests(u32 maxCount, const std::function<bool(const glm::ivec3 &)> &isKnown) {
+    std::vector<glm::ivec3> requests = {};
+    if (complete || maxCount == 0) { return requests; }
+
+    struct Candidate {
+        glm::ivec3 chunkPos;
+        f32 priority;
+    };
+
+    std::vector<Candidate> candidates = {};
+    for (const glm::ivec3 &loadOffset : loadOffsets) {
+        glm::ivec3 chunkPos = {centerChunk.x + loadOffset.x, loadOffset.y, centerChunk.z + loadOffset.z};
+        if (isKnown(chunkPos)) { continue; }
+        glm::ivec3 offset = chunkPos - centerChunk;
+
+        // chunks straight ahead count as half as far away, chunks behind as one and a half times
+        f32 distance = glm::length(glm::vec3{offset});
+        f32 facing = distance > 0.0f ? glm::dot(glm::vec3{offset} / distance, viewDir) : 1.0f;
+        candidates.push_back({chunkPos, distance * (1.0f - 0.5f * facing)});
+    }
+
+    complete = candidates.size() <= maxCount;
+
+    u32 count = std::min(maxCount, static_cast<u32>(candidates.size()));
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), [](const Candidate &a, const Candidate &b) {
+        return a.priority < b.priority;
+    });
+
+    for (u32 i = 0; i < count; i++) {
+        requests.push_back(candidates[i].chunkPos);
+    }
+    return requests;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <vector>
+#include <daxa/types.hpp>
+#include <glm/glm.hpp>
+
+#include "voxels.hpp"
+
+using namespace daxa::types;
+
+// radii are in chunks measured on the xz plane from the camera's chunk, the unload radius is larger than the
+// load radius so chunks on the border don't flicker in and out.
+// vertically the same chunk layers are loaded wherever the camera is: the ones the terrain surface can reach
+// are meshed and one more layer below and above them is loaded so every meshed chunk has all its neighbours
+struct StreamingSettings {
+    i32 loadRadius = 24;
+    i32 unloadRadius = 26;
+    // lowest and highest meshed chunk layer, WorldGenerator::surfaceLayers
+    glm::ivec2 meshedLayers = {-2, 1};
+    // chunks further away than lodDistances[i] are meshed at lod i + 1
+    std::array<i32, 3> lodDistances = {6, 12, 18};
+};
+
+// decides which chunks around the camera should be loaded and which should be evicted,
+// it doesn't own any chunks, App does the generating and freeing
+struct ChunkStreamer {
+    explicit ChunkStreamer(const StreamingSettings &_settings = {});
+
+    // chunk containing a world position
+    static glm::ivec3 chunkAt(const glm::vec3 &worldPos);
+
+    // returns true when the camera moved into another chunk since the last call
+    bool update(const glm::vec3 &worldPos, const glm::vec3 &viewDir);
+
+    bool shouldLoad(const glm::ivec3 &chunkPos) const;
+    bool shouldKeep(const glm::ivec3 &chunkPos) const;
+    // inside meshedLayers
+    bool shouldMesh(const glm::ivec3 &chunkPos) const;
+    u32 lodFor(const glm::ivec3 &chunkPos) const;
+
+    // up to maxCount chunks inside the load radius that aren't known yet,
+    // nearest first with chunks in front of the camera counting as closer
+    std::vector<glm::ivec3> nextRequests(u32 maxCount, const std::function<bool(const glm::ivec3 &)> &isKnown);
+
+    StreamingSettings settings;
+    glm::ivec3 centerChunk = {};
+    glm::vec3 viewDir = {0.0f, 0.0f, -1.0f};
+    // nothing is missing around the current center, skips scanning until the camera changes chunk
+    bool complete = false;
+    // every position inside the load radius, x and z relative to the center chunk and y the chunk layer
+    std::vector<glm::ivec3> loadOffsets = {};
+};
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "terrain.hpp"
+
+// fractal noise within -1 to 1
+static FastNoise::SmartNode<> createDensityGraph() {
+    auto OpenSimplex = FastNoise::New<FastNoise::OpenSimplex2>();
+    auto FractalFBm = FastNoise::New<FastNoise::FractalFBm>();
+    FractalFBm->SetSource(OpenSimplex);
+    FractalFBm->SetGain(0.280f);
+    FractalFBm->SetOctaveCount(4);
+    FractalFBm->SetLacunarity(4.0f);
+    auto DomainScale = FastNoise::New<FastNoise::DomainScale>();
+    DomainScale->SetSource(FractalFBm);
+    DomainScale->SetScale(0.86f);
+    return DomainScale;
+}
+
+static FastNoise::SmartNode<> createHeightmapGraph() {
+    auto OpenSimplex = FastNoise::New<FastNoise::OpenSimplex2>();
+    auto FractalFBm = FastNoise::New<FastNoise::FractalFBm>();
+    FractalFBm->SetSource(OpenSimplex);
+    FractalFBm->SetGain(0.5f);
+    FractalFBm->SetOctaveCount(3);
+    FractalFBm->SetLacunarity(2.0f);
+    return FractalFBm;
+}
+
+WorldGenerator::WorldGenerator(const WorldGeneratorSettings &_settings) : settings{_settings} {
+    heightmap = createHeightmapGraph();
+    if (settings.encodedNodeTree.empty()) {
+        density = createDensityGraph();
+        return;
+    }
+    density = FastNoise::NewFromEncodedNodeTree(settings.encodedNodeTree.c_str());
+    if (!density) {
+        throw std::runtime_error("failed to decode the terrain node tree");
+    }
+}
+
+glm::ivec2 WorldGenerator::surfaceLayers() const {
+    // the heightmap noise stays within -1 to 1 and the density moves the surface by up to densityAmplitude,
+    // the lowest air block can have a grass block below it one layer further down
+    const f32 reach = settings.heightAmplitude + settings.densityAmplitude;
+    const f32 lowest = std::floor(static_cast<f32>(settings.surfaceHeight) - reach) - 1.0f;
+    const f32 highest = std::ceil(static_cast<f32>(settings.surfaceHeight) + reach);
+    return glm::ivec2{glm::floor(glm::vec2{lowest, highest} / static_cast<f32>(CHUNK_SIZE))};
+}
+
+// FNV-1a, hashed field by field so padding doesn't end up in the key
+static void hashBytes(u64 &hash, const void *data, usize size) {
+    const u8 *bytes = static_cast<const u8 *>(data);
+    for (usize i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+    }
+}
+
+u64 WorldGenerator::key() const {
+    u64 hash = 0xcbf29ce484222325ull;
+    hashBytes(hash, &GENERATOR_VERSION, sizeof(GENERATOR_VERSION));
+    hashBytes(hash, &settings.seed, sizeof(settings.seed));
+    hashBytes(hash, &settings.frequency, sizeof(settings.frequency));
+    hashBytes(hash, &settings.heightFrequency, sizeof(settings.heightFrequency));
+    hashBytes(hash, &settings.surfaceHeight, sizeof(settings.surfaceHeight));
+    hashBytes(hash, &settings.heightAmplitude, sizeof(settings.heightAmplitude));
+    hashBytes(hash, &settings.densityAmplitude, sizeof(settings.densityAmplitude));
+    hashBytes(hash, &settings.dirtDepth, sizeof(settings.dirtDepth));
+    hashBytes(hash, settings.encodedNodeTree.data(), settings.encodedNodeTree.size());
+    return hash;
+}
+
+void WorldGenerator::generate(ChunkVoxels &voxels, const glm::ivec3 &chunkPos) const {
+    ChunkVoxels *chunk = &voxels;
+    generateBatch({&chunk, 1}, chunkPos, {1, 1, 1});
+}
+
+u32 WorldGenerator::generateBatch(std::span<ChunkVoxels *const> voxels, const glm::ivec3 &firstChunk, const glm::ivec3 &chunkCount) const {
+    const glm::ivec3 size = chunkCount * CHUNK_SIZE;
+    const glm::ivec3 origin = firstChunk * CHUNK_SIZE;
+    const usize heightRowStride = static_cast<usize>(size.x);
+
+    // stage 1: the surface height of every column in the box, kept per worker instead of allocated every call
+    thread_local std::vector<f32> heights = {};
+    heights.resize(static_cast<usize>(size.x) * static_cast<usize>(size.z));
+    heightmap->GenUniformGrid2D(heights.data(), origin.x, origin.z, size.x, size.z, settings.heightFrequency, settings.seed);
+    for (f32 &height : heights) {
+        height = static_cast<f32>(settings.surfaceHeight) + height * settings.heightAmplitude;
+    }
+
+    // stage 2: chunks entirely above the highest or below the lowest surface of their columns are uniform,
+    // the others decide which layers of the box need the density
+    enum struct Fill { Air, Stone, Density };
+    std::vector<Fill> fills(voxels.size(), Fill::Air);
+    i32 densityMinY = chunkCount.y;
+    i32 densityMaxY = -1;
+    for (i32 z = 0; z < chunkCount.z; z++) {
+        for (i32 x = 0; x < chunkCount.x; x++) {
+            f32 minHeight = heights[static_cast<usize>(z * CHUNK_SIZE) * heightRowStride + static_cast<usize>(x * CHUNK_SIZE)];
+            f32 maxHeight = minHeight;
+            for (i32 dz = 0; dz < CHUNK_SIZE; dz++) {
+                const f32 *row = heights.data() + static_cast<usize>(z * CHUNK_SIZE + dz) * heightRowStride + static_cast<usize>(x * CHUNK_SIZE);
+                for (i32 dx = 0; dx < CHUNK_SIZE; dx++) {
+                    minHeight = std::min(minHeight, row[dx]);
+                    maxHeight = std::max(maxHeight, row[dx]);
+                }
+            }
+
+            for (i32 y = 0; y < chunkCount.y; y++) {
+                const usize index = static_cast<usize>((z * chunkCount.y + y) * chunkCount.x + x);
+                if (voxels[index] == nullptr) { continue; }
+                const f32 bottom = static_cast<f32>(origin.y + y * CHUNK_SIZE);
+                const f32 top = bottom + static_cast<f32>(CHUNK_SIZE - 1);
+                if (bottom - maxHeight > settings.densityAmplitude) {
+                    fills[index] = Fill::Air;
+                } else if (minHeight - top > settings.densityAmplitude + static_cast<f32>(settings.dirtDepth + 1)) {
+                    fills[index] = Fill::Stone;
+                } else {
+                    fills[index] = Fill::Density;
+                    densityMinY = std::min(densityMinY, y);
+                    densityMaxY = std::max(densityMaxY, y);
+                    continue;
+                }
+                voxels[index]->fill(fills[index] == Fill::Stone ? BlockID::Stone : BlockID::Air);
+            }
+        }
+    }
+
+    // stage 3: one density grid over the layers that need it, reaching surfaceRows blocks further up
+    // so the surface pass knows what lies above the top layer
+    const i32 surfaceRows = settings.dirtDepth + 1;
+    const i32 densityLayers = densityMaxY - densityMinY + 1;
+    if (densityLayers <= 0) { return 0; }
+    const i32 gridHeight = densityLayers * CHUNK_SIZE + surfaceRows;
+    thread_local std::vector<f32> densities = {};
+    densities.resize(static_cast<usize>(size.x) * static_cast<usize>(gridHeight) * static_cast<usize>(size.z));
+    density->GenUniformGrid3D(densities.data(), origin.x, origin.y + densityMinY * CHUNK_SIZE, origin.z,
+                              size.x, gridHeight, size.z, settings.frequency, settings.seed);
+
+    // stage 4: every column is walked from the top counting the solid blocks since the last air block,
+    // the first one is grass, the next dirtDepth are dirt and the rest stone
+    const usize rowStride = static_cast<usize>(size.x);
+    const usize sliceStride = rowStride * static_cast<usize>(gridHeight);
+    thread_local std::vector<BlockID> blocks = {};
+    blocks.resize(static_cast<usize>(densityLayers) * CHUNK_VOLUME);
+    u32 densityChunks = 0;
+    for (i32 z = 0; z < chunkCount.z; z++) {
+        for (i32 x = 0; x < chunkCount.x; x++) {
+            auto chunkAt = [&](i32 layer) {
+                return static_cast<usize>((z * chunkCount.y + densityMinY + layer) * chunkCount.x + x);
+            };
+            bool anyDensity = false;
+            for (i32 layer = 0; layer < densityLayers; layer++) {
+                anyDensity |= voxels[chunkAt(layer)] != nullptr && fills[chunkAt(layer)] == Fill::Density;
+            }
+            if (!anyDensity) { continue; }
+
+            for (i32 dz = 0; dz < CHUNK_SIZE; dz++) {
+                const f32 *heightRow = heights.data() + static_cast<usize>(z * CHUNK_SIZE + dz) * heightRowStride + static_cast<usize>(x * CHUNK_SIZE);
+                std::array<u8, CHUNK_SIZE> solidAbove = {};
+                for (i32 gy = gridHeight - 1; gy >= 0; gy--) {
+                    const f32 blockY = static_cast<f32>(origin.y + densityMinY * CHUNK_SIZE + gy);
+                    const f32 *densityRow = densities.data() + static_cast<usize>(z * CHUNK_SIZE + dz) * sliceStride +
+                                            static_cast<usize>(gy) * rowStride + static_cast<usize>(x * CHUNK_SIZE);
+                    const i32 layer = gy / CHUNK_SIZE;
+                    // the rows above the top layer only count the solid blocks, they have no chunk to write to
+                    const bool inChunk = layer < densityLayers;
+                    BlockID *blockRow = inChunk
+                        ? blocks.data() + static_cast<usize>(layer) * CHUNK_VOLUME + voxelIndex({0, gy % CHUNK_SIZE, dz}, CHUNK_SIZE)
+                        : nullptr;
+                    for (i32 dx = 0; dx < CHUNK_SIZE; dx++) {
+                        const bool solid = blockY - heightRow[dx] + densityRow[dx] * settings.densityAmplitude <= 0.0f;
+                        const u8 depth = solid ? static_cast<u8>(std::min<i32>(solidAbove[dx] + 1, surfaceRows + 1)) : u8{0};
+                        solidAbove[dx] = depth;
+                        if (inChunk) {
+                            blockRow[dx] = depth == 0 ? BlockID::Air : depth == 1 ? BlockID::Grass : depth <= surfaceRows ? BlockID::Dirt : BlockID::Stone;
+                        }
+                    }
+                }
+            }
+
+            for (i32 layer = 0; layer < densityLayers; layer++) {
+                if (voxels[chunkAt(layer)] == nullptr || fills[chunkAt(layer)] != Fill::Density) { continue; }
+                densityChunks++;
+                voxels[chunkAt(layer)]->assign(std::span<const BlockID, CHUNK_VOLUME>{blocks.data() + static_cast<usize>(layer) * CHUNK_VOLUME, CHUNK_VOLUME});
+            }
+        }
+    }
+    return densityChunks;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <FastNoise/FastNoise.h>
+
+#include "voxels.hpp"
+
+// bumped whenever the same settings start producing different voxels, so saved and cached chunks are discarded
+static constexpr u32 GENERATOR_VERSION = 1;
+
+// heights and amplitudes are in blocks
+struct WorldGeneratorSettings {
+    i32 seed = 1337;
+    // of the 3D density
+    f32 frequency = 0.05f;
+    // the surface height is surfaceHeight + heightAmplitude * 2D noise
+    f32 heightFrequency = 0.01f;
+    i32 surfaceHeight = 0;
+    f32 heightAmplitude = 12.0f;
+    // the 3D density moves the surface by up to this much, making overhangs and caves near it
+    f32 densityAmplitude = 4.0f;
+    // dirt layers below the grass block on top of every column of solid blocks
+    i32 dirtDepth = 3;
+    // a node tree exported from FastNoise2's NoiseTool for the 3D density, its output has to stay within -1 to 1,
+    // empty uses the built in graph
+    std::string encodedNodeTree = "";
+};
+
+// the terrain every chunk is generated from, shared by all workers: the node graphs are built once and only read
+// afterwards, so generate can run on any number of threads at once and a chunk position always produces the
+// same voxels for the same settings.
+// a block is solid when its height above the 2D heightmap plus the 3D density is at most 0, the density is only
+// evaluated for chunks that reach into the band densityAmplitude around the surface, the rest are filled as
+// uniform air or stone straight from the heightmap. solid blocks are grass when air is above them and dirt
+// for dirtDepth blocks below that, found in the same pass over the density grid
+struct WorldGenerator {
+    explicit WorldGenerator(const WorldGeneratorSettings &_settings = {});
+
+    // fills the voxels of the chunk at chunkPos (in chunks)
+    void generate(ChunkVoxels &voxels, const glm::ivec3 &chunkPos) const;
+    // fills a box of chunkCount chunks starting at firstChunk with one heightmap and one density grid call, which
+    // amortizes FastNoise's per call overhead, voxels holds one pointer per chunk of the box in voxelIndex order,
+    // null ones are skipped; every voxel samples the same position as it would when its chunk is generated on its own.
+    // returns how many of the chunks needed the 3D density
+    u32 generateBatch(std::span<ChunkVoxels *const> voxels, const glm::ivec3 &firstChunk, const glm::ivec3 &chunkCount) const;
+
+    // lowest and highest chunk layer the surface can reach, everything below is stone and everything above air
+    glm::ivec2 surfaceLayers() const;
+
+    // hash of the settings and GENERATOR_VERSION, chunks saved or cached under another key came from another world
+    u64 key() const;
+
+    WorldGeneratorSettings settings;
+    FastNoise::SmartNode<> heightmap;
+    FastNoise::SmartNode<> density;
+};
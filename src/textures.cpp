@@ -27,6 +27,9 @@ Textures::Textures(daxa::Device &device): device{device} {
   this->atlas_sampler = device.create_sampler({
       .magnification_filter = daxa::Filter::NEAREST,
       .minification_filter = daxa::Filter::LINEAR,
+      .address_mode_u = daxa::SamplerAddressMode::REPEAT,
+      .address_mode_v = daxa::SamplerAddressMode::REPEAT,
+      .address_mode_w = daxa::SamplerAddressMode::REPEAT,
       .min_lod = 0,
       .max_lod = 0,
       .name = "atlas_sampler",
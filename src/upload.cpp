@@ -0,0 +1,99 @@
+#include <cstring>
+
+#include "upload.hpp"
+
+UploadManager::UploadManager(daxa::Device &_device, u32 _ringSize, u32 _frameBudget) : device{_device}, ringSize{_ringSize}, frameBudget{_frameBudget} {
+    this->ringBuffer = device.create_buffer({
+        .size = ringSize,
+        .allocate_info = daxa::MemoryFlagBits::HOST_ACCESS_SEQUENTIAL_WRITE,
+        .name = "upload ring",
+    });
+    this->timeline = device.create_timeline_semaphore({
+        .initial_value = 0,
+        .name = "upload timeline",
+    });
+}
+
+UploadManager::~UploadManager() {
+    timeline.wait_for_value(submittedValue);
+    device.destroy_buffer(ringBuffer);
+}
+
+void UploadManager::reclaim() {
+    const u64 completedValue = timeline.value();
+    while (!submissions.empty() && submissions.front().timelineValue <= completedValue) {
+        inFlightBytes -= submissions.front().bytes;
+        submissions.pop_front();
+    }
+}
+
+u32 UploadManager::alignedSize(u32 size) {
+    return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+bool UploadManager::canStage(u32 size) {
+    reclaim();
+    size = alignedSize(size);
+
+    if (frameBytes != 0 && frameBytes + size > frameBudget) {
+        return false;
+    }
+
+    // an allocation that doesn't fit before the end of the ring skips the rest of it
+    const u32 skipped = head + size > ringSize ? ringSize - head : 0;
+    return inFlightBytes + frameBytes + skipped + size <= ringSize;
+}
+
+void UploadManager::stage(daxa::BufferId dst, u32 dstOffset, const void *data, u32 size) {
+    const u32 stagedSize = alignedSize(size);
+
+    if (head + stagedSize > ringSize) {
+        frameBytes += ringSize - head;
+        head = 0;
+    }
+
+    std::memcpy(device.get_host_address_as<u8>(ringBuffer) + head, data, size);
+    copies.push_back(Copy { .dst = dst, .dstOffset = dstOffset, .srcOffset = head, .size = size });
+
+    head = (head + stagedSize) % ringSize;
+    frameBytes += stagedSize;
+    totalUploadedBytes += size;
+}
+
+void UploadManager::flush() {
+    if (copies.empty()) {
+        return;
+    }
+
+    daxa::CommandList command_list = device.create_command_list({.name = "upload command list"});
+    // chunk descriptors are rewritten in place, earlier frames may still be reading them
+    command_list.pipeline_barrier({
+        .src_access = daxa::AccessConsts::READ,
+        .dst_access = daxa::AccessConsts::TRANSFER_WRITE,
+    });
+    for (const Copy &copy : copies) {
+        command_list.copy_buffer_to_buffer({
+            .src_buffer = ringBuffer,
+            .src_offset = copy.srcOffset,
+            .dst_buffer = copy.dst,
+            .dst_offset = copy.dstOffset,
+            .size = copy.size,
+        });
+    }
+    command_list.pipeline_barrier({
+        .src_access = daxa::AccessConsts::TRANSFER_WRITE,
+        .dst_access = daxa::AccessConsts::READ,
+    });
+    command_list.complete();
+
+    submittedValue++;
+    device.submit_commands({
+        .command_lists = {std::move(command_list)},
+        .signal_timeline_semaphores = {{timeline, submittedValue}},
+    });
+
+    submissions.push_back(Submission { .timelineValue = submittedValue, .bytes = frameBytes });
+    inFlightBytes += frameBytes;
+    frameBytes = 0;
+    copies.clear();
+}
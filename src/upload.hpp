@@ -0,0 +1,55 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <daxa/daxa.hpp>
+
+using namespace daxa::types;
+
+// batches buffer uploads through a persistently mapped staging ring,
+// all copies staged during a frame go out in one command list when flush is called
+struct UploadManager {
+    static constexpr u32 ALIGNMENT = 16;
+
+    UploadManager(daxa::Device &_device, u32 _ringSize, u32 _frameBudget);
+    ~UploadManager();
+
+    // true when size bytes fit into this frame's budget and the free part of the ring,
+    // the first upload of a frame may go over the budget so large meshes can't get stuck
+    bool canStage(u32 size);
+    // ring bytes a stage of size bytes takes, checking the sum of several covers staging them one after another
+    static u32 alignedSize(u32 size);
+    void stage(daxa::BufferId dst, u32 dstOffset, const void *data, u32 size);
+
+    // submits the staged copies, ring space is reclaimed once the upload timeline passes the submission
+    void flush();
+
+    daxa::Device &device;
+    daxa::BufferId ringBuffer;
+    daxa::TimelineSemaphore timeline;
+    u64 submittedValue = 0;
+    u32 ringSize;
+    u32 frameBudget; // bytes per flush
+    u32 head = 0;
+    u32 inFlightBytes = 0;
+    u32 frameBytes = 0;
+    u64 totalUploadedBytes = 0;
+
+  private:
+    struct Submission {
+        u64 timelineValue;
+        u32 bytes; // ring bytes to give back, including any skipped space at the end of the ring
+    };
+
+    struct Copy {
+        daxa::BufferId dst;
+        u32 dstOffset;
+        u32 srcOffset;
+        u32 size;
+    };
+
+    void reclaim();
+
+    std::deque<Submission> submissions = {};
+    std::vector<Copy> copies = {};
+};
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "voxels.hpp"
+
+// narrowest supported index width that can address paletteSize entries
+static u32 bitsFor(usize paletteSize) {
+    u32 bits = 0;
+    while ((usize{1} << bits) < paletteSize) {
+        bits = bits == 0 ? 1 : bits * 2;
+    }
+    if (bits > 16) {
+        throw std::runtime_error("chunk palette has too many entries");
+    }
+    return bits;
+}
+
+void ChunkVoxels::setVoxel(const glm::ivec3 &p, BlockID id) {
+    auto entry = std::find(palette.begin(), palette.end(), id);
+    const u32 paletteIndex = static_cast<u32>(entry - palette.begin());
+    if (entry == palette.end()) {
+        palette.push_back(id);
+        if (palette.size() > (usize{1} << bitsPerIndex)) {
+            repack(bitsFor(palette.size()));
+        }
+    }
+    if (bitsPerIndex != 0) {
+        writeIndex(indexOf(p), paletteIndex);
+    }
+}
+
+void ChunkVoxels::assign(std::span<const BlockID, CHUNK_VOLUME> blocks) {
+    palette.clear();
+    std::array<u32, CHUNK_VOLUME> indices;
+    for (usize i = 0; i < blocks.size(); i++) {
+        // terrain repeats the same block in long runs, checking the previous one first skips most searches
+        if (i > 0 && blocks[i] == blocks[i - 1]) {
+            indices[i] = indices[i - 1];
+            continue;
+        }
+        auto entry = std::find(palette.begin(), palette.end(), blocks[i]);
+        if (entry == palette.end()) {
+            palette.push_back(blocks[i]);
+            entry = palette.end() - 1;
+        }
+        indices[i] = static_cast<u32>(entry - palette.begin());
+    }
+
+    bitsPerIndex = bitsFor(palette.size());
+    words.assign(static_cast<usize>(CHUNK_VOLUME) * bitsPerIndex / 64, 0);
+    if (bitsPerIndex != 0) {
+        for (usize i = 0; i < indices.size(); i++) {
+            writeIndex(i, indices[i]);
+        }
+    }
+    words.shrink_to_fit();
+    palette.shrink_to_fit();
+}
+
+void ChunkVoxels::compact() {
+    if (bitsPerIndex == 0) { return; }
+
+    std::array<BlockID, CHUNK_VOLUME> blocks;
+    for (usize i = 0; i < blocks.size(); i++) {
+        blocks[i] = palette[readIndex(i)];
+    }
+    assign(blocks);
+}
+
+void ChunkVoxels::fill(BlockID id) {
+    palette = {id};
+    words = {};
+    bitsPerIndex = 0;
+}
+
+usize ChunkVoxels::memoryUsage() const {
+    return sizeof(ChunkVoxels) + palette.capacity() * sizeof(BlockID) + words.capacity() * sizeof(u64);
+}
+
+void ChunkVoxels::writeIndex(usize index, u32 value) {
+    const usize bit = index * bitsPerIndex;
+    const u64 mask = ((u64{1} << bitsPerIndex) - 1) << (bit % 64);
+    words[bit / 64] = (words[bit / 64] & ~mask) | (static_cast<u64>(value) << (bit % 64));
+}
+
+void ChunkVoxels::repack(u32 bits) {
+    std::vector<u64> packed(static_cast<usize>(CHUNK_VOLUME) * bits / 64, 0);
+    std::swap(words, packed);
+    const u32 oldBits = bitsPerIndex;
+    bitsPerIndex = bits;
+    for (usize i = 0; i < static_cast<usize>(CHUNK_VOLUME); i++) {
+        // a uniform chunk only had palette entry 0
+        u32 value = 0;
+        if (oldBits != 0) {
+            const usize bit = i * oldBits;
+            value = static_cast<u32>(packed[bit / 64] >> (bit % 64)) & ((1u << oldBits) - 1);
+        }
+        writeIndex(i, value);
+    }
+}
+
+PaddedVoxels::PaddedVoxels(const ChunkVoxels &center, const std::array<const ChunkVoxels *, 6> &neighbors)
+    : emptyCenter{center.isUniform() && center.palette[0] == BlockID::Air} {
+    for (i32 z = 0; z < CHUNK_SIZE; z++) {
+        for (i32 y = 0; y < CHUNK_SIZE; y++) {
+            for (i32 x = 0; x < CHUNK_SIZE; x++) {
+                setVoxel({x, y, z}, center.getVoxel({x, y, z}));
+            }
+        }
+    }
+
+    for (u32 face = 0; face < 6; face++) {
+        if (neighbors[face] == nullptr) { continue; }
+
+        // the layer of the neighbour touching this chunk goes into the border on that side
+        const i32 axis = static_cast<i32>(face / 2);
+        const bool positive = face % 2 == 1;
+        for (i32 u = 0; u < CHUNK_SIZE; u++) {
+            for (i32 v = 0; v < CHUNK_SIZE; v++) {
+                glm::ivec3 src = {};
+                src[axis] = positive ? 0 : CHUNK_SIZE - 1;
+                src[(axis + 1) % 3] = u;
+                src[(axis + 2) % 3] = v;
+
+                glm::ivec3 dst = src;
+                dst[axis] = positive ? CHUNK_SIZE : -1;
+                setVoxel(dst, neighbors[face]->getVoxel(src));
+            }
+        }
+    }
+}
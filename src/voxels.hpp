@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <span>
+#include <vector>
+#include <glm/glm.hpp>
+#include <daxa/types.hpp>
+
+using namespace daxa::types;
+
+static constexpr i32 CHUNK_SIZE = 16;
+static constexpr i32 PADDED_CHUNK_SIZE = CHUNK_SIZE + 2;
+static constexpr i32 CHUNK_VOLUME = CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+
+enum struct BlockID: u8 {
+    Air,
+    Grass, 
+    Dirt,
+    Stone
+};
+
+// every voxel grid (chunks, padded chunks, lod cells) is laid out linearly with x varying fastest, then y, then z,
+// the order FastNoise's GenUniformGrid3D writes in, loops over a grid nest z outside and x inside
+inline usize voxelIndex(const glm::ivec3 &p, i32 size) {
+    return static_cast<usize>((p.z * size + p.y) * size + p.x);
+}
+
+// faces are ordered -x, +x, -y, +y, -z, +z
+inline const std::array<glm::ivec3, 6> FACE_NORMALS = {
+    glm::ivec3{ -1, 0, 0 }, glm::ivec3{ +1, 0, 0 },
+    glm::ivec3{ 0, -1, 0 }, glm::ivec3{ 0, +1, 0 },
+    glm::ivec3{ 0, 0, -1 }, glm::ivec3{ 0, 0, +1 },
+};
+
+// texture array layer of each face of each block, layers follow texture_names in textures.cpp
+inline constexpr std::array<std::array<u32, 6>, 4> BLOCK_FACE_LAYERS = {{
+    {0, 0, 0, 0, 0, 0}, // air
+    {2, 2, 3, 1, 2, 2}, // grass: grass-side, dirt below, grass-top above
+    {3, 3, 3, 3, 3, 3}, // dirt
+    {4, 4, 4, 4, 4, 4}, // stone
+}};
+
+inline u32 faceLayer(BlockID id, u32 face) {
+    return BLOCK_FACE_LAYERS[static_cast<usize>(id)][face];
+}
+
+// block volume of a single chunk, plain data without any GPU resources,
+// palette compressed: a uniform chunk is only its palette entry, otherwise every voxel is a
+// bitsPerIndex wide index into the palette, packed into 64 bit words
+struct ChunkVoxels {
+    // everything outside of the chunk reads as air
+    BlockID getVoxel(const glm::ivec3 &p) const {
+        if(p.x < 0 || p.x >= CHUNK_SIZE) {
+            return BlockID::Air;
+        }
+        if(p.y < 0 || p.y >= CHUNK_SIZE) {
+            return BlockID::Air;
+        }
+        if(p.z < 0 || p.z >= CHUNK_SIZE) {
+            return BlockID::Air;
+        }
+        if (bitsPerIndex == 0) {
+            return palette[0];
+        }
+        return palette[readIndex(indexOf(p))];
+    }
+
+    // grows the palette and the index width when needed, compact() shrinks them again
+    void setVoxel(const glm::ivec3 &p, BlockID id);
+    // replaces every voxel, blocks are in indexOf order, the result is already compact
+    void assign(std::span<const BlockID, CHUNK_VOLUME> blocks);
+    // drops palette entries no voxel uses anymore and packs the indices as narrow as possible
+    void compact();
+    // makes the chunk uniform
+    void fill(BlockID id);
+
+    bool isUniform() const { return bitsPerIndex == 0; }
+    // heap and inline bytes this chunk's voxels take
+    usize memoryUsage() const;
+
+    static usize indexOf(const glm::ivec3 &p) {
+        return voxelIndex(p, CHUNK_SIZE);
+    }
+
+    std::vector<BlockID> palette = {BlockID::Air};
+    std::vector<u64> words = {};
+    // 0, 1, 2, 4, 8 or 16, widths that divide 64 so no index straddles two words
+    u32 bitsPerIndex = 0;
+
+  private:
+    u32 readIndex(usize index) const {
+        const usize bit = index * bitsPerIndex;
+        return static_cast<u32>(words[bit / 64] >> (bit % 64)) & ((1u << bitsPerIndex) - 1);
+    }
+
+    void writeIndex(usize index, u32 value);
+    // rewrites every index with a new width, palette has to fit into it
+    void repack(u32 bits);
+};
+
+// chunk voxels with a one block border copied from the six face neighbours, which is all the meshers read,
+// missing neighbours as well as the edges and corners of the border read as air
+struct PaddedVoxels {
+    PaddedVoxels(const ChunkVoxels &center, const std::array<const ChunkVoxels *, 6> &neighbors);
+
+    // p goes from -1 to CHUNK_SIZE on every axis
+    BlockID getVoxel(const glm::ivec3 &p) const {
+        return blockIds[voxelIndex(p + 1, PADDED_CHUNK_SIZE)];
+    }
+
+    void setVoxel(const glm::ivec3 &p, BlockID id) {
+        blockIds[voxelIndex(p + 1, PADDED_CHUNK_SIZE)] = id;
+    }
+
+    std::array<BlockID, PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE * PADDED_CHUNK_SIZE> blockIds = {};
+    // the chunk itself is all air, it has no faces whatever the border holds
+    bool emptyCenter = false;
+};
@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "world_cache.hpp"
+
+static constexpr u32 CACHE_MAGIC = 0x48434357; // "WCCH"
+// bumped whenever the layout or what generation and meshing produce changes
+static constexpr u32 CACHE_VERSION = 6;
+// a power of two so probing can wrap with a mask, comfortably above the chunks a session streams in
+static constexpr u32 CACHE_ENTRY_COUNT = 1 << 16;
+// a chunk is looked for in this many slots at most, past that the table counts as full
+static constexpr u32 CACHE_MAX_PROBES = 64;
+
+struct CacheHeader {
+    u32 magic;
+    u32 version;
+    u64 generatorKey;
+    u32 entryCount;
+    // PACKED_VERTICES switches the vertex layout, meshes cached with the other one can't be read back
+    u32 vertexSize;
+    u32 faceSize;
+    u32 padding;
+    u64 dataEnd; // next free byte of the data area
+};
+
+// offsets are from the start of the file, 0 means that part isn't cached, the capacities are the bytes
+// reserved behind the offsets, which a later store reuses when it fits
+struct CacheEntry {
+    i32 x, y, z;
+    u32 used;
+    u64 voxelOffset;
+    u32 voxelCapacity;
+    u32 paletteSize;
+    u32 bitsPerIndex;
+    u32 meshCapacity;
+    u64 meshOffset;
+    u32 meshSize; // bytes
+    u32 mesher;
+    u32 backend;
+    u32 lod;
+    u32 quadCount;
+    u32 faceQuadCounts[6];
+};
+
+static constexpr u64 TABLE_OFFSET = sizeof(CacheHeader);
+static constexpr u64 DATA_OFFSET = TABLE_OFFSET + static_cast<u64>(CACHE_ENTRY_COUNT) * sizeof(CacheEntry);
+
+WorldCache::WorldCache(const std::filesystem::path &path, u64 _generatorKey, u64 _capacity) : generatorKey{_generatorKey}, capacity{_capacity} {
+    if (capacity <= DATA_OFFSET) {
+        throw std::runtime_error("world cache is too small for its table");
+    }
+    std::filesystem::create_directories(path.parent_path());
+    const bool existed = std::filesystem::exists(path) && std::filesystem::file_size(path) == capacity;
+
+    // the file is sized up front, on Linux file systems that support sparse files pages that were never written
+    // don't take space on disk, on Windows the whole file is allocated
+#if defined(_WIN32)
+    fileHandle = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open world cache " + path.string());
+    }
+    mappingHandle = CreateFileMappingW(fileHandle, nullptr, PAGE_READWRITE, static_cast<DWORD>(capacity >> 32), static_cast<DWORD>(capacity), nullptr);
+    if (mappingHandle == nullptr) {
+        throw std::runtime_error("failed to map world cache " + path.string());
+    }
+    mapping = static_cast<u8 *>(MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, capacity));
+    if (mapping == nullptr) {
+        throw std::runtime_error("failed to map world cache " + path.string());
+    }
+#else
+    fileDescriptor = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fileDescriptor < 0 || ftruncate(fileDescriptor, static_cast<off_t>(capacity)) != 0) {
+        throw std::runtime_error("failed to open world cache " + path.string());
+    }
+    void *address = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fileDescriptor, 0);
+    if (address == MAP_FAILED) {
+        throw std::runtime_error("failed to map world cache " + path.string());
+    }
+    mapping = static_cast<u8 *>(address);
+#endif
+
+    // a cache written for another world or layout is started over
+    const CacheHeader &header = *reinterpret_cast<const CacheHeader *>(mapping);
+    if (!existed || header.magic != CACHE_MAGIC || header.version != CACHE_VERSION || header.generatorKey != generatorKey ||
+        header.entryCount != CACHE_ENTRY_COUNT || header.vertexSize != sizeof(Vertex) || header.faceSize != sizeof(Face) ||
+        header.dataEnd < DATA_OFFSET || header.dataEnd > capacity) {
+        clear();
+    }
+}
+
+WorldCache::~WorldCache() {
+#if defined(_WIN32)
+    if (mapping != nullptr) { UnmapViewOfFile(mapping); }
+    if (mappingHandle != nullptr) { CloseHandle(mappingHandle); }
+    if (fileHandle != INVALID_HANDLE_VALUE && fileHandle != nullptr) { CloseHandle(fileHandle); }
+#else
+    if (mapping != nullptr) { munmap(mapping, capacity); }
+    if (fileDescriptor >= 0) { close(fileDescriptor); }
+#endif
+}
+
+void WorldCache::clear() {
+    std::memset(mapping, 0, DATA_OFFSET);
+    *reinterpret_cast<CacheHeader *>(mapping) = CacheHeader {
+        .magic = CACHE_MAGIC,
+        .version = CACHE_VERSION,
+        .generatorKey = generatorKey,
+        .entryCount = CACHE_ENTRY_COUNT,
+        .vertexSize = sizeof(Vertex),
+        .faceSize = sizeof(Face),
+        .padding = 0,
+        .dataEnd = DATA_OFFSET,
+    };
+}
+
+CacheEntry *WorldCache::findEntry(const glm::ivec3 &chunkPos, bool create) {
+    CacheEntry *table = reinterpret_cast<CacheEntry *>(mapping + TABLE_OFFSET);
+    u32 hash = static_cast<u32>(chunkPos.x) * 73856093u ^ static_cast<u32>(chunkPos.y) * 19349663u ^ static_cast<u32>(chunkPos.z) * 83492791u;
+    for (u32 probe = 0; probe < CACHE_MAX_PROBES; probe++) {
+        CacheEntry &entry = table[(hash + probe) & (CACHE_ENTRY_COUNT - 1)];
+        if (entry.used == 0) {
+            if (!create) { return nullptr; }
+            entry = {};
+            entry.x = chunkPos.x;
+            entry.y = chunkPos.y;
+            entry.z = chunkPos.z;
+            entry.used = 1;
+            return &entry;
+        }
+        if (entry.x == chunkPos.x && entry.y == chunkPos.y && entry.z == chunkPos.z) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+std::optional<u64> WorldCache::allocate(u64 size) {
+    CacheHeader &header = *reinterpret_cast<CacheHeader *>(mapping);
+    const u64 offset = header.dataEnd;
+    if (offset + size > capacity) { return std::nullopt; }
+    header.dataEnd += size;
+    return offset;
+}
+
+CacheEntry *WorldCache::reserve(const glm::ivec3 &chunkPos, bool mesh, u64 size, u64 &offset) {
+    // empty meshes still take 8 bytes, a non zero offset marks them as cached
+    size = std::max<u64>((size + 7) & ~u64{7}, 8);
+
+    for (u32 attempt = 0; attempt < 2; attempt++) {
+        CacheEntry *entry = findEntry(chunkPos, true);
+        if (entry != nullptr) {
+            u64 &published = mesh ? entry->meshOffset : entry->voxelOffset;
+            u32 &reserved = mesh ? entry->meshCapacity : entry->voxelCapacity;
+            if (published != 0 && reserved >= size) {
+                offset = published;
+                published = 0;
+                return entry;
+            }
+
+            // the old bytes are left unused until the cache is cleared
+            std::optional<u64> newOffset = allocate(size);
+            if (newOffset.has_value()) {
+                offset = *newOffset;
+                published = 0;
+                reserved = static_cast<u32>(size);
+                return entry;
+            }
+        }
+        // the table or the data area is full, everything cached so far is dropped and the chunks streamed in from now on fill it again
+        clear();
+    }
+    return nullptr;
+}
+
+bool WorldCache::inDataArea(u64 offset, u64 reserved, u64 size) const {
+    return offset >= DATA_OFFSET && offset <= capacity && reserved <= capacity - offset && size <= reserved;
+}
+
+bool WorldCache::loadVoxels(const glm::ivec3 &chunkPos, ChunkVoxels &voxels) {
+    std::lock_guard lock{mutex};
+    const CacheEntry *entry = findEntry(chunkPos, false);
+    if (entry == nullptr || entry->voxelOffset == 0) { return false; }
+
+    // the file outlives crashes in the middle of a store, anything that doesn't add up counts as not cached
+    const u32 bits = entry->bitsPerIndex;
+    if (bits > 16 || (bits & (bits - 1)) != 0 || entry->paletteSize == 0 || entry->paletteSize > (1u << bits)) { return false; }
+    const u64 paletteBytes = (entry->paletteSize * sizeof(BlockID) + 7) & ~u64{7};
+    const usize wordCount = static_cast<usize>(CHUNK_VOLUME) * bits / 64;
+    if (!inDataArea(entry->voxelOffset, entry->voxelCapacity, paletteBytes + wordCount * sizeof(u64))) { return false; }
+
+    const BlockID *palette = reinterpret_cast<const BlockID *>(mapping + entry->voxelOffset);
+    const u64 *words = reinterpret_cast<const u64 *>(mapping + entry->voxelOffset + paletteBytes);
+    if (std::any_of(palette, palette + entry->paletteSize, [](BlockID id) { return id > BlockID::Stone; })) { return false; }
+    voxels.palette.assign(palette, palette + entry->paletteSize);
+    voxels.words.assign(words, words + wordCount);
+    voxels.bitsPerIndex = bits;
+
+    // indices past the end of the palette read as air instead of out of bounds
+    voxels.palette.resize(usize{1} << bits, BlockID::Air);
+    voxels.compact();
+    return true;
+}
+
+void WorldCache::storeVoxels(const glm::ivec3 &chunkPos, const ChunkVoxels &voxels) {
+    // the words start 8 byte aligned behind the palette
+    const u64 paletteBytes = (voxels.palette.size() * sizeof(BlockID) + 7) & ~u64{7};
+    const u64 wordBytes = voxels.words.size() * sizeof(u64);
+
+    std::lock_guard lock{mutex};
+    u64 offset = 0;
+    CacheEntry *entry = reserve(chunkPos, false, paletteBytes + wordBytes, offset);
+    if (entry == nullptr) { return; }
+
+    std::memcpy(mapping + offset, voxels.palette.data(), voxels.palette.size() * sizeof(BlockID));
+    std::memcpy(mapping + offset + paletteBytes, voxels.words.data(), wordBytes);
+    entry->paletteSize = static_cast<u32>(voxels.palette.size());
+    entry->bitsPerIndex = voxels.bitsPerIndex;
+    // the offset goes in last, a store that was cut short leaves the voxels uncached
+    std::atomic_signal_fence(std::memory_order_release);
+    entry->voxelOffset = offset;
+}
+
+bool WorldCache::loadMesh(const glm::ivec3 &chunkPos, MesherType mesher, MeshBackend backend, u32 lod, ChunkMesh &mesh) {
+    std::lock_guard lock{mutex};
+    const CacheEntry *entry = findEntry(chunkPos, false);
+    if (entry == nullptr || entry->meshOffset == 0) { return false; }
+    if (entry->mesher != static_cast<u32>(mesher) || entry->backend != static_cast<u32>(backend) || entry->lod != lod) { return false; }
+
+    const u64 quadSize = backend == MeshBackend::Faces ? sizeof(Face) : 4 * sizeof(Vertex);
+    u64 bucketQuads = 0;
+    for (u32 quads : entry->faceQuadCounts) {
+        bucketQuads += quads;
+    }
+    if (entry->meshSize != entry->quadCount * quadSize || bucketQuads != entry->quadCount ||
+        !inDataArea(entry->meshOffset, entry->meshCapacity, entry->meshSize)) {
+        return false;
+    }
+
+    mesh = ChunkMesh { .backend = backend, .lod = lod };
+    mesh.quadCount = entry->quadCount;
+    std::memcpy(mesh.faceQuadCounts.data(), entry->faceQuadCounts, sizeof(entry->faceQuadCounts));
+    if (backend == MeshBackend::Faces) {
+        const Face *faces = reinterpret_cast<const Face *>(mapping + entry->meshOffset);
+        mesh.faces.assign(faces, faces + entry->meshSize / sizeof(Face));
+    } else {
+        const Vertex *vertices = reinterpret_cast<const Vertex *>(mapping + entry->meshOffset);
+        mesh.vertices.assign(vertices, vertices + entry->meshSize / sizeof(Vertex));
+    }
+    return true;
+}
+
+void WorldCache::storeMesh(const glm::ivec3 &chunkPos, MesherType mesher, const ChunkMesh &mesh) {
+    // a chunk keeps a single mesh, the one of its latest lod and backend, rewritten in place when it fits
+    std::lock_guard lock{mutex};
+    u64 offset = 0;
+    CacheEntry *entry = reserve(chunkPos, true, mesh.byteSize(), offset);
+    if (entry == nullptr) { return; }
+
+    if (mesh.byteSize() != 0) {
+        std::memcpy(mapping + offset, mesh.data(), mesh.byteSize());
+    }
+    entry->meshSize = mesh.byteSize();
+    entry->mesher = static_cast<u32>(mesher);
+    entry->backend = static_cast<u32>(mesh.backend);
+    entry->lod = mesh.lod;
+    entry->quadCount = mesh.quadCount;
+    std::memcpy(entry->faceQuadCounts, mesh.faceQuadCounts.data(), sizeof(entry->faceQuadCounts));
+    std::atomic_signal_fence(std::memory_order_release);
+    entry->meshOffset = offset;
+}
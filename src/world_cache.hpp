@@ -0,0 +1,61 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <daxa/types.hpp>
+#include <glm/glm.hpp>
+
+#include "voxels.hpp"
+#include "mesher.hpp"
+
+using namespace daxa::types;
+
+struct CacheEntry;
+
+// memory mapped cache of chunk voxels and finished meshes for a single generator key, so a warm start
+// copies them straight out of the mapping instead of generating, decoding or meshing them again.
+// the file has a fixed layout: a header, an open addressing table keyed by chunk position and the data
+// the table points into. data that grew is appended, and once the table or the data area is full the whole
+// cache is cleared and fills up again with the chunks streamed in from then on
+struct WorldCache {
+    WorldCache(const std::filesystem::path &path, u64 _generatorKey, u64 _capacity);
+    ~WorldCache();
+
+    WorldCache(const WorldCache &) = delete;
+    WorldCache &operator=(const WorldCache &) = delete;
+
+    // all of these are thread safe
+    bool loadVoxels(const glm::ivec3 &chunkPos, ChunkVoxels &voxels);
+    void storeVoxels(const glm::ivec3 &chunkPos, const ChunkVoxels &voxels);
+    // only a mesh built with the same mesher, backend and lod is returned
+    bool loadMesh(const glm::ivec3 &chunkPos, MesherType mesher, MeshBackend backend, u32 lod, ChunkMesh &mesh);
+    void storeMesh(const glm::ivec3 &chunkPos, MesherType mesher, const ChunkMesh &mesh);
+
+    u64 generatorKey; // WorldGenerator::key
+    u64 capacity; // bytes, the whole file
+
+  private:
+    // these have to be called with the mutex held
+    // empties the table and the data area
+    void clear();
+    // returns nullptr when the chunk isn't cached and create is false or the table is full
+    CacheEntry *findEntry(const glm::ivec3 &chunkPos, bool create);
+    // returns the offset of size bytes of the data area or nothing when it is full
+    std::optional<u64> allocate(u64 size);
+    // finds or creates the chunk's entry and room for size bytes of its voxels or mesh, which goes to offset, clearing
+    // the cache when it is full, returns nullptr when size doesn't even fit into an empty cache.
+    // the entry's voxel or mesh offset is zeroed, the store sets it again once the data and its sizes are written
+    CacheEntry *reserve(const glm::ivec3 &chunkPos, bool mesh, u64 size, u64 &offset);
+    // size bytes at offset lie inside the reserved bytes, which lie inside the data area
+    bool inDataArea(u64 offset, u64 reserved, u64 size) const;
+
+    std::mutex mutex = {};
+    u8 *mapping = nullptr;
+#if defined(_WIN32)
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+};